@@ -0,0 +1,143 @@
+//! Triangulation Benchmark
+//!
+//! Times each Triangulator backend over a corpus of polygon sets and reports
+//! triangles per second, plus heap allocations per run when built with the
+//! alloc-stats feature:
+//!
+//! ```text
+//! cargo run --release --example triangulation_bench --features alloc-stats
+//! ```
+//!
+//! The convex fast path is disabled so that every case exercises the backend.
+
+use meshbool::{Polygons, SimplePolygon, Triangulator, triangulate};
+use nalgebra::{Point2, Vector2};
+use std::f64::consts::PI;
+use std::hint::black_box;
+use std::time::{Duration, Instant};
+
+#[cfg(feature = "alloc-stats")]
+#[global_allocator]
+static ALLOC: meshbool::alloc_stats::PeakAlloc = meshbool::alloc_stats::PeakAlloc::new();
+
+const BACKENDS: [Triangulator; 3] = [
+    Triangulator::EarClip,
+    Triangulator::Monotone,
+    Triangulator::Auto,
+];
+
+fn main() {
+    let corpus = [
+        ("convex 256", vec![ring(Point2::origin(), 256, |_| 1.0)]),
+        ("concave star 2k", vec![star(2000, 0.7)]),
+        ("comb 400 teeth", vec![comb(400)]),
+        ("keyholed 20x20 rings", ring_sheet(20)),
+        ("degenerate 1k", vec![degenerate(1000)]),
+        ("star 10k", vec![star(10_000, 0.9)]),
+        ("huge star 100k", vec![star(100_000, 0.9)]),
+    ];
+
+    println!(
+        "{:<22} {:<9} {:>9} {:>11} {:>12} {:>10}",
+        "case", "backend", "tris", "ms/run", "Mtris/s", "allocs/run"
+    );
+    for (name, polygons) in &corpus {
+        for backend in BACKENDS {
+            let (num_tri, time, allocs) = bench(polygons, backend);
+            let allocs = allocs.map_or("-".to_string(), |a| a.to_string());
+            println!(
+                "{:<22} {:<9} {:>9} {:>11.3} {:>12.2} {:>10}",
+                name,
+                format!("{backend:?}"),
+                num_tri,
+                time.as_secs_f64() * 1e3,
+                num_tri as f64 / time.as_secs_f64() / 1e6,
+                allocs
+            );
+        }
+    }
+}
+
+///Returns the triangle count, the mean time per run, and the allocations of
+///one run if they are being counted.
+fn bench(polygons: &Polygons, backend: Triangulator) -> (usize, Duration, Option<usize>) {
+    let before = alloc_count();
+    let num_tri = triangulate(polygons, -1.0, false, backend).len();
+    let allocs = alloc_count().map(|after| after - before.unwrap());
+
+    let start = Instant::now();
+    let mut runs = 0;
+    while runs == 0 || (start.elapsed() < Duration::from_millis(300) && runs < 1000) {
+        black_box(triangulate(black_box(polygons), -1.0, false, backend));
+        runs += 1;
+    }
+    (num_tri, start.elapsed() / runs, allocs)
+}
+
+#[cfg(feature = "alloc-stats")]
+fn alloc_count() -> Option<usize> {
+    Some(meshbool::alloc_stats::alloc_count())
+}
+
+#[cfg(not(feature = "alloc-stats"))]
+fn alloc_count() -> Option<usize> {
+    None
+}
+
+///A CCW loop of n verts around center with radius(i); pass a negative n for a
+///CW loop, i.e. a hole.
+fn ring(center: Point2<f64>, n: i32, radius: impl Fn(usize) -> f64) -> SimplePolygon {
+    let dir = n.signum() as f64;
+    let n = n.unsigned_abs() as usize;
+    (0..n)
+        .map(|i| {
+            let angle = dir * 2.0 * PI * i as f64 / n as f64;
+            center + radius(i) * Vector2::new(angle.cos(), angle.sin())
+        })
+        .collect()
+}
+
+fn star(n: i32, inner: f64) -> SimplePolygon {
+    ring(Point2::origin(), n, |i| if i % 2 == 0 { 1.0 } else { inner })
+}
+
+///Teeth pointing up and down, so the sweep sees many split and merge verts.
+fn comb(teeth: usize) -> SimplePolygon {
+    let mut poly = Vec::new();
+    for i in 0..teeth {
+        let x = 4.0 * i as f64;
+        poly.extend([(x, -1.0), (x + 1.0, -1.0), (x + 1.0, -10.0), (x + 3.0, -10.0)]);
+    }
+    poly.extend([(4.0 * teeth as f64, -10.0), (4.0 * teeth as f64, 10.0)]);
+    for i in (0..teeth).rev() {
+        let x = 4.0 * i as f64;
+        poly.extend([(x + 3.0, 10.0), (x + 3.0, 1.0), (x + 2.0, 1.0), (x + 2.0, 10.5)]);
+    }
+    poly.push((0.0, 10.0));
+    poly.into_iter().map(|(x, y)| Point2::new(x, y)).collect()
+}
+
+///Separate islands, each with a hole that has to be keyholed.
+fn ring_sheet(size: usize) -> Polygons {
+    let mut polygons = Vec::new();
+    for i in 0..size {
+        for j in 0..size {
+            let center = Point2::new(3.0 * i as f64, 3.0 * j as f64);
+            polygons.push(ring(center, 24, |k| if k % 2 == 0 { 1.0 } else { 0.9 }));
+            polygons.push(ring(center, -12, |_| 0.4));
+        }
+    }
+    polygons
+}
+
+///A jagged outline with a repeated vert and a colinear vert on every edge, as
+///left by Boolean cuts through tessellated faces.
+fn degenerate(n: i32) -> SimplePolygon {
+    let outline = star(n, 0.8);
+    let mut poly = Vec::with_capacity(3 * outline.len());
+    for (i, &p) in outline.iter().enumerate() {
+        let q = outline[(i + 1) % outline.len()];
+        poly.extend([p, p, nalgebra::center(&p, &q)]);
+    }
+    poly
+}
@@ -0,0 +1,110 @@
+//! Optional heap accounting, enabled by the `alloc-stats` feature. Install
+//! PeakAlloc as the global allocator to measure the peak scratch memory of
+//! operations like boolean(), finish() or get_mesh_gl():
+//!
+//! ```ignore
+//! #[global_allocator]
+//! static ALLOC: meshbool::alloc_stats::PeakAlloc = meshbool::alloc_stats::PeakAlloc::new();
+//!
+//! let (result, peak) = meshbool::alloc_stats::measure_peak(|| meshbool::boolean(&a, &b, op));
+//! ```
+//!
+//! The counters are process-wide, so allocations from other threads running at
+//! the same time are included in the measurement.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::sync::atomic::{AtomicUsize, Ordering};
+
+static CURRENT: AtomicUsize = AtomicUsize::new(0);
+static PEAK: AtomicUsize = AtomicUsize::new(0);
+static COUNT: AtomicUsize = AtomicUsize::new(0);
+
+fn on_alloc(size: usize) {
+    COUNT.fetch_add(1, Ordering::Relaxed);
+    let current = CURRENT.fetch_add(size, Ordering::Relaxed) + size;
+    PEAK.fetch_max(current, Ordering::Relaxed);
+}
+
+fn on_dealloc(size: usize) {
+    CURRENT.fetch_sub(size, Ordering::Relaxed);
+}
+
+///A global allocator that forwards to an inner allocator while tracking the
+///live and peak number of heap bytes.
+pub struct PeakAlloc<A = System> {
+    inner: A,
+}
+
+impl PeakAlloc<System> {
+    pub const fn new() -> Self {
+        Self { inner: System }
+    }
+}
+
+impl<A> PeakAlloc<A> {
+    pub const fn with_allocator(inner: A) -> Self {
+        Self { inner }
+    }
+}
+
+unsafe impl<A: GlobalAlloc> GlobalAlloc for PeakAlloc<A> {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        let ptr = unsafe { self.inner.alloc(layout) };
+        if !ptr.is_null() {
+            on_alloc(layout.size());
+        }
+        ptr
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        let ptr = unsafe { self.inner.alloc_zeroed(layout) };
+        if !ptr.is_null() {
+            on_alloc(layout.size());
+        }
+        ptr
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        unsafe { self.inner.dealloc(ptr, layout) };
+        on_dealloc(layout.size());
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        let new_ptr = unsafe { self.inner.realloc(ptr, layout, new_size) };
+        if !new_ptr.is_null() {
+            on_dealloc(layout.size());
+            on_alloc(new_size);
+        }
+        new_ptr
+    }
+}
+
+///Heap bytes currently allocated through PeakAlloc.
+pub fn current_bytes() -> usize {
+    CURRENT.load(Ordering::Relaxed)
+}
+
+///Highest value of current_bytes() since the last reset_peak().
+pub fn peak_bytes() -> usize {
+    PEAK.load(Ordering::Relaxed)
+}
+
+///Number of allocations and reallocations made through PeakAlloc so far.
+pub fn alloc_count() -> usize {
+    COUNT.load(Ordering::Relaxed)
+}
+
+///Restarts peak tracking from the current allocation level.
+pub fn reset_peak() {
+    PEAK.store(CURRENT.load(Ordering::Relaxed), Ordering::Relaxed);
+}
+
+///Runs f and returns its result along with the peak number of heap bytes it
+///held above the level at which it started. Returns 0 for the peak if
+///PeakAlloc is not installed as the global allocator.
+pub fn measure_peak<T>(f: impl FnOnce() -> T) -> (T, usize) {
+    reset_peak();
+    let base = current_bytes();
+    let result = f();
+    (result, peak_bytes().saturating_sub(base))
+}
@@ -378,7 +378,32 @@ impl Collider {
         self.internal_children.len()
     }
 
-    fn num_leaves(&self) -> usize {
+    ///Bytes allocated for the node boxes, parents and children of the tree.
+    pub(crate) fn memory_footprint(&self) -> usize {
+        self.node_bbox.capacity() * mem::size_of::<Aabb>()
+            + self.node_parent.capacity() * mem::size_of::<i32>()
+            + self.internal_children.capacity() * mem::size_of::<(i32, i32)>()
+    }
+
+    ///The node boxes, parents and internal children, for serialization.
+    pub(crate) fn parts(&self) -> (&[Aabb], &[i32], &[(i32, i32)]) {
+        (&self.node_bbox, &self.node_parent, &self.internal_children)
+    }
+
+    ///Reassembles a tree from the arrays returned by parts().
+    pub(crate) fn from_parts(
+        node_bbox: Vec<Aabb>,
+        node_parent: Vec<i32>,
+        internal_children: Vec<(i32, i32)>,
+    ) -> Self {
+        Self {
+            node_bbox,
+            node_parent,
+            internal_children,
+        }
+    }
+
+    pub(crate) fn num_leaves(&self) -> usize {
         if self.internal_children.is_empty() {
             0
         } else {
@@ -221,6 +221,7 @@ impl SafeFrom<usize> for usize {
     }
 }
 
+#[derive(Clone, Copy)]
 pub struct OrderedF64(pub f64);
 
 impl Ord for OrderedF64 {
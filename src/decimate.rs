@@ -0,0 +1,363 @@
+use crate::meshboolimpl::MeshBoolImpl;
+use crate::shared::next_halfedge;
+use nalgebra::{Point3, Vector3};
+use std::cmp::Ordering;
+use std::collections::BinaryHeap;
+
+///Squared distances to a set of planes, stored as the upper triangle of the
+///symmetric 4x4 matrix sum(p p^T) over planes p = (n, d) with n.x + d = 0.
+#[derive(Clone, Copy, Default)]
+struct Quadric {
+    q: [f64; 10],
+}
+
+impl Quadric {
+    fn plane(normal: Vector3<f64>, point: Point3<f64>, weight: f64) -> Self {
+        let d = -normal.dot(&point.coords);
+        let (a, b, c) = (normal.x, normal.y, normal.z);
+        Self {
+            q: [
+                a * a, a * b, a * c, a * d, //
+                b * b, b * c, b * d, //
+                c * c, c * d, //
+                d * d,
+            ]
+            .map(|x| weight * x),
+        }
+    }
+
+    fn add(&mut self, other: &Quadric) {
+        for i in 0..10 {
+            self.q[i] += other.q[i];
+        }
+    }
+
+    fn error(&self, p: Point3<f64>) -> f64 {
+        let q = &self.q;
+        let (x, y, z) = (p.x, p.y, p.z);
+        let e = q[0] * x * x
+            + 2.0 * q[1] * x * y
+            + 2.0 * q[2] * x * z
+            + 2.0 * q[3] * x
+            + q[4] * y * y
+            + 2.0 * q[5] * y * z
+            + 2.0 * q[6] * y
+            + q[7] * z * z
+            + 2.0 * q[8] * z
+            + q[9];
+        e.max(0.0)
+    }
+}
+
+///A candidate collapse of edge's startVert into its endVert. It is stale once
+///the edge joins different verts, or either vert has been touched by a collapse
+///since it was queued.
+struct Candidate {
+    cost: f64,
+    edge: i32,
+    start_vert: i32,
+    end_vert: i32,
+    start_stamp: u32,
+    end_stamp: u32,
+}
+
+impl PartialEq for Candidate {
+    fn eq(&self, other: &Self) -> bool {
+        self.cmp(other) == Ordering::Equal
+    }
+}
+
+impl Eq for Candidate {}
+
+impl PartialOrd for Candidate {
+    fn partial_cmp(&self, other: &Self) -> Option<Ordering> {
+        Some(self.cmp(other))
+    }
+}
+
+impl Ord for Candidate {
+    // Reversed, so that BinaryHeap pops the cheapest collapse first, ties to the
+    // lower edge index.
+    fn cmp(&self, other: &Self) -> Ordering {
+        other
+            .cost
+            .total_cmp(&self.cost)
+            .then(other.edge.cmp(&self.edge))
+    }
+}
+
+///Evaluates the quadric error of collapsing each halfedge's startVert onto its
+///endVert. Every edge is independent.
+struct EdgeCost<'a> {
+    r#impl: &'a MeshBoolImpl,
+    quadric: &'a [Quadric],
+}
+
+impl<'a> EdgeCost<'a> {
+    fn call(&self, edge: usize) -> Option<f64> {
+        let half = &self.r#impl.halfedge[edge];
+        if half.paired_halfedge < 0 {
+            return None;
+        }
+        let mut q = self.quadric[half.start_vert as usize];
+        q.add(&self.quadric[half.end_vert as usize]);
+        Some(q.error(self.r#impl.vert_pos[half.end_vert as usize]))
+    }
+}
+
+impl MeshBoolImpl {
+    ///The face a triangle belongs to for decimation: its input mesh and
+    ///face_id. Unlike same_face(), this ignores coplanar_id, since decimating a
+    ///curved surface has to merge triangles that are not coplanar.
+    fn decimation_face(&self, tri: usize) -> (i32, i32) {
+        let r#ref = &self.mesh_relation.tri_ref[tri];
+        (r#ref.mesh_id, r#ref.face_id)
+    }
+
+    ///Whether the edge separates two faces or two sets of properties, and so
+    ///must be kept in place by a boundary quadric.
+    fn is_decimation_boundary(&self, edge: usize) -> bool {
+        let pair = self.halfedge[edge].paired_halfedge as usize;
+        self.decimation_face(edge / 3) != self.decimation_face(pair / 3)
+            || self.halfedge[edge].prop_vert
+                != self.halfedge[next_halfedge(pair as i32) as usize].prop_vert
+            || self.halfedge[pair].prop_vert
+                != self.halfedge[next_halfedge(edge as i32) as usize].prop_vert
+    }
+
+    fn decimation_quadrics(&self) -> Vec<Quadric> {
+        let mut quadric = vec![Quadric::default(); self.num_vert()];
+        for tri in 0..self.num_tri() {
+            if self.halfedge[3 * tri].start_vert < 0 {
+                continue;
+            }
+            let normal = self.face_normal[tri];
+            let v0 = self.vert_pos[self.halfedge[3 * tri].start_vert as usize];
+            let plane = Quadric::plane(normal, v0, 1.0);
+            for i in 0..3 {
+                quadric[self.halfedge[3 * tri + i].start_vert as usize].add(&plane);
+            }
+        }
+
+        // Keep face and property boundaries in place with a plane through each
+        // boundary edge, perpendicular to its triangle.
+        for edge in 0..self.halfedge.len() {
+            let half = self.halfedge[edge];
+            if half.paired_halfedge < 0
+                || half.start_vert > half.end_vert
+                || !self.is_decimation_boundary(edge)
+            {
+                continue;
+            }
+            let p0 = self.vert_pos[half.start_vert as usize];
+            let p1 = self.vert_pos[half.end_vert as usize];
+            let normal = (p1 - p0).cross(&self.face_normal[edge / 3]).normalize();
+            if !normal.x.is_finite() {
+                continue;
+            }
+            let plane = Quadric::plane(normal, p0, 1.0);
+            quadric[half.start_vert as usize].add(&plane);
+            quadric[half.end_vert as usize].add(&plane);
+        }
+        quadric
+    }
+
+    ///Checks that collapsing edge's startVert onto its endVert keeps faces and
+    ///property seams intact and flips no triangle. startVert may only be removed
+    ///from the interior of a face, or from a boundary between two faces along
+    ///that boundary, with uniform properties on each side.
+    fn can_decimate(&self, edge: i32) -> bool {
+        let half = self.halfedge[edge as usize];
+        if half.paired_halfedge < 0 {
+            return false;
+        }
+        let pair = half.paired_halfedge;
+        let face0 = self.decimation_face(edge as usize / 3);
+        let face1 = self.decimation_face(pair as usize / 3);
+        let prop0 = half.prop_vert;
+        let prop1 = self.halfedge[next_halfedge(pair) as usize].prop_vert;
+        let p_old = self.vert_pos[half.start_vert as usize];
+        let p_new = self.vert_pos[half.end_vert as usize];
+
+        let mut ok = true;
+        self.for_vert(edge, |current| {
+            if !ok {
+                return;
+            }
+            let tri = current as usize / 3;
+            let face = self.decimation_face(tri);
+            let prop = self.halfedge[current as usize].prop_vert;
+            if !((face == face0 && prop == prop0) || (face == face1 && prop == prop1)) {
+                ok = false;
+                return;
+            }
+            // The two triangles of the edge are removed.
+            if tri == edge as usize / 3 || tri == pair as usize / 3 {
+                return;
+            }
+
+            let p1 = self.vert_pos[self.halfedge[current as usize].end_vert as usize];
+            let p2 = self.vert_pos
+                [self.halfedge[next_halfedge(current) as usize].end_vert as usize];
+            // face_normal is not kept up to date by earlier collapses, so
+            // compare against the triangle as it is now.
+            let normal = (p1 - p_new).cross(&(p2 - p_new));
+            if normal.dot(&(p1 - p_old).cross(&(p2 - p_old))) <= 0.0 {
+                ok = false;
+            }
+        });
+        ok
+    }
+
+    ///Collapses edges in order of increasing quadric error until at most
+    ///target_tris triangles remain or the next collapse would move the surface
+    ///by more than max_error. Each collapse removes a vert in favor of one of its
+    ///neighbors, so the remaining verts and their properties are unchanged.
+    pub(crate) fn decimate(&mut self, target_tris: usize, max_error: f64) {
+        if self.halfedge.is_empty() {
+            return;
+        }
+        let max_cost = max_error * max_error;
+        let mut quadric = self.decimation_quadrics();
+        let mut stamp = vec![0u32; self.num_vert()];
+
+        // The costs are computed independently per edge, and only ordered
+        // afterward.
+        let cost = EdgeCost {
+            r#impl: self,
+            quadric: &quadric,
+        };
+        let mut queue: BinaryHeap<Candidate> = (0..self.halfedge.len())
+            .filter_map(|edge| {
+                let cost = cost.call(edge).filter(|&cost| cost <= max_cost)?;
+                let half = &self.halfedge[edge];
+                Some(Candidate {
+                    cost,
+                    edge: edge as i32,
+                    start_vert: half.start_vert,
+                    end_vert: half.end_vert,
+                    start_stamp: 0,
+                    end_stamp: 0,
+                })
+            })
+            .collect();
+
+        // A tetrahedron is the smallest closed manifold.
+        let target_tris = target_tris.max(4);
+        let mut num_tri = self.num_tri();
+        let mut scratch_buffer = Vec::with_capacity(10);
+        let mut fan = Vec::new();
+        let mut ring = Vec::new();
+        let mut dead_tris = Vec::new();
+        let mut side0 = Vec::new();
+        while num_tri > target_tris {
+            let Some(candidate) = queue.pop() else {
+                break;
+            };
+            let edge = candidate.edge;
+            let half = self.halfedge[edge as usize];
+            if half.paired_halfedge < 0
+                || half.start_vert != candidate.start_vert
+                || half.end_vert != candidate.end_vert
+                || stamp[half.start_vert as usize] != candidate.start_stamp
+                || stamp[half.end_vert as usize] != candidate.end_stamp
+                || !self.can_decimate(edge)
+            {
+                continue;
+            }
+
+            // The halfedges out of both verts and their pairs. Afterward these
+            // still include a live halfedge out of every remaining vert of the
+            // neighborhood.
+            fan.clear();
+            self.for_vert(edge, |current| fan.push(current));
+            let num_start_fan = fan.len();
+            self.for_vert(half.paired_halfedge, |current| fan.push(current));
+            for i in 0..fan.len() {
+                fan.push(self.halfedge[fan[i] as usize].paired_halfedge);
+            }
+            // Which side of the edge each of startVert's triangles is on, as
+            // checked by can_decimate().
+            let face0 = self.decimation_face(edge as usize / 3);
+            side0.clear();
+            for &current in &fan[..num_start_fan] {
+                side0.push(
+                    self.decimation_face(current as usize / 3) == face0
+                        && self.halfedge[current as usize].prop_vert == half.prop_vert,
+                );
+            }
+            let end_prop0 = self.halfedge[next_halfedge(edge) as usize].prop_vert;
+            let end_prop1 = self.halfedge[half.paired_halfedge as usize].prop_vert;
+
+            self.apply_collapse(edge, &mut scratch_buffer);
+            scratch_buffer.clear();
+            // apply_collapse() matches properties by same_face(), which also
+            // tells coplanar regions apart, so redo it by decimation face. Without
+            // properties, propVert just follows startVert.
+            let num_prop = self.num_prop();
+            for (&current, &side0) in fan[..num_start_fan].iter().zip(&side0) {
+                if self.halfedge[current as usize].start_vert != half.end_vert {
+                    continue;
+                }
+                self.halfedge[current as usize].prop_vert = if num_prop == 0 {
+                    half.end_vert
+                } else if side0 {
+                    end_prop0
+                } else {
+                    end_prop1
+                };
+            }
+            let q = quadric[half.start_vert as usize];
+            quadric[half.end_vert as usize].add(&q);
+            // form_loop() may have duplicated verts.
+            stamp.resize(self.vert_pos.len(), 0);
+            quadric.resize(self.vert_pos.len(), Quadric::default());
+
+            ring.clear();
+            dead_tris.clear();
+            for &current in &fan {
+                let vert = self.halfedge[current as usize].start_vert;
+                if vert < 0 {
+                    dead_tris.push(current / 3);
+                } else {
+                    ring.push((vert, current));
+                }
+            }
+            dead_tris.sort_unstable();
+            dead_tris.dedup();
+            num_tri -= dead_tris.len();
+            ring.sort_unstable();
+            ring.dedup_by_key(|&mut (vert, _)| vert);
+
+            for &(vert, _) in &ring {
+                stamp[vert as usize] += 1;
+            }
+            let cost = EdgeCost {
+                r#impl: self,
+                quadric: &quadric,
+            };
+            for &(_, first) in &ring {
+                self.for_vert(first, |current| {
+                    for edge in [current, self.halfedge[current as usize].paired_halfedge] {
+                        let half = self.halfedge[edge as usize];
+                        if let Some(c) = cost.call(edge as usize).filter(|&c| c <= max_cost) {
+                            queue.push(Candidate {
+                                cost: c,
+                                edge,
+                                start_vert: half.start_vert,
+                                end_vert: half.end_vert,
+                                start_stamp: stamp[half.start_vert as usize],
+                                end_stamp: stamp[half.end_vert as usize],
+                            });
+                        }
+                    }
+                });
+            }
+        }
+
+        self.face_normal.clear();
+        self.remove_unreferenced_verts();
+        self.finish();
+        self.mark_coplanar();
+    }
+}
@@ -1,9 +1,9 @@
 use crate::meshboolimpl::MeshBoolImpl;
+use crate::parallel::exclusive_scan_in_place;
 use crate::shared::{Halfedge, get_axis_aligned_projection, next_halfedge};
 use crate::utils::ccw;
 use nalgebra::{Point2, Point3, Vector3, distance};
-use std::collections::HashMap;
-use std::collections::hash_map::Entry;
+use std::mem;
 
 fn tri_of(edge: i32) -> Vector3<i32> {
     let mut tri_edge = Vector3::default();
@@ -152,11 +152,11 @@ struct FlagStore {
 }
 
 impl FlagStore {
-    fn run_seq<F>(&mut self, n: usize, mut pred: impl Pred, mut f: F)
+    fn run_seq<F>(&mut self, edges: &[usize], mut pred: impl Pred, mut f: F)
     where
         F: FnMut(&mut MeshBoolImpl, usize),
     {
-        for i in 0..n {
+        for &i in edges {
             if pred.call(i) {
                 self.s.push(i);
             }
@@ -167,11 +167,104 @@ impl FlagStore {
         }
     }
 
-    fn run<F>(&mut self, n: usize, pred: impl Pred, f: F)
+    fn run<F>(&mut self, edges: &[usize], pred: impl Pred, f: F)
     where
         F: FnMut(&mut MeshBoolImpl, usize),
     {
-        self.run_seq(n, pred, f);
+        self.run_seq(edges, pred, f);
+    }
+}
+
+///The triangles that simplification may change, i.e. those with a vert at or
+///above first_new_vert, in index order. Every edge the predicates can flag
+///belongs to one of them, or for swaps is paired with one, so scanning just
+///these gives the same flags as scanning the whole mesh. A collapse relabels
+///the fan of the removed vert, which is added before each collapse, while
+///form_loop() rewires fans further away and so triggers a full rescan.
+struct Worklist {
+    first_new_vert: i32,
+    tris: Vec<usize>,
+    touched: Vec<usize>,
+    rescan: bool,
+}
+
+impl Worklist {
+    fn new(r#impl: &MeshBoolImpl, first_new_vert: i32) -> Self {
+        let mut worklist = Self {
+            first_new_vert,
+            tris: Vec::new(),
+            touched: Vec::new(),
+            rescan: false,
+        };
+        worklist.scan(r#impl);
+        worklist
+    }
+
+    fn is_new(&self, r#impl: &MeshBoolImpl, tri: usize) -> bool {
+        (0..3).any(|i| r#impl.halfedge[3 * tri + i].start_vert >= self.first_new_vert)
+    }
+
+    fn scan(&mut self, r#impl: &MeshBoolImpl) {
+        self.tris.clear();
+        for tri in 0..r#impl.num_tri() {
+            if self.is_new(r#impl, tri) {
+                self.tris.push(tri);
+            }
+        }
+    }
+
+    ///Records the fan of edge's startVert, which is about to be collapsed, and
+    ///returns the vert count to pass to after_collapse().
+    fn before_collapse(&mut self, r#impl: &MeshBoolImpl, edge: usize) -> usize {
+        if r#impl.halfedge[edge].paired_halfedge >= 0 {
+            r#impl.for_vert(edge as i32, |current| self.touched.push(current as usize / 3));
+        }
+        r#impl.vert_pos.len()
+    }
+
+    fn after_collapse(&mut self, r#impl: &MeshBoolImpl, num_vert: usize) {
+        self.rescan |= r#impl.vert_pos.len() != num_vert;
+    }
+
+    ///Brings the triangle list up to date with the collapses since the last
+    ///update.
+    fn update(&mut self, r#impl: &MeshBoolImpl) {
+        if self.rescan {
+            self.scan(r#impl);
+            self.rescan = false;
+        } else if !self.touched.is_empty() {
+            self.tris.append(&mut self.touched);
+            self.tris.sort_unstable();
+            self.tris.dedup();
+            let mut tris = mem::take(&mut self.tris);
+            tris.retain(|&tri| self.is_new(r#impl, tri));
+            self.tris = tris;
+        }
+        self.touched.clear();
+    }
+
+    ///The live halfedges of the listed triangles in index order, along with
+    ///their pairs if with_pairs is true.
+    fn edges(&self, r#impl: &MeshBoolImpl, with_pairs: bool) -> Vec<usize> {
+        let mut edges = Vec::with_capacity(3 * self.tris.len() * (1 + with_pairs as usize));
+        for &tri in &self.tris {
+            for edge in 3 * tri..3 * tri + 3 {
+                let pair = r#impl.halfedge[edge].paired_halfedge;
+                if pair < 0 {
+                    continue;
+                }
+                edges.push(edge);
+                if with_pairs {
+                    edges.push(pair as usize);
+                }
+            }
+        }
+
+        if with_pairs {
+            edges.sort_unstable();
+            edges.dedup();
+        }
+        edges
     }
 }
 
@@ -216,15 +309,20 @@ impl MeshBoolImpl {
         }
 
         self.cleanup_topology();
-        self.collapse_short_edges(first_new_vert);
-        self.collapse_colinear_edges(first_new_vert);
-        self.swap_degenerates(first_new_vert);
+        let mut worklist = Worklist::new(self, first_new_vert);
+        self.collapse_short_edges(first_new_vert, &mut worklist);
+        self.collapse_colinear_edges(first_new_vert, &mut worklist);
+        self.swap_degenerates(first_new_vert, &worklist);
     }
 
-    fn collapse_short_edges(&mut self, first_new_vert: i32) {
+    fn collapse_short_edges(
+        &mut self,
+        first_new_vert: i32,
+        worklist: &mut Worklist,
+    ) {
         let mut s = FlagStore::default();
         let mut num_flagged = 0;
-        let nb_edges = self.halfedge.len();
+        let edges = worklist.edges(self, false);
 
         let mut scratch_buffer = Vec::with_capacity(10);
         // Short edges get to skip several checks and hence remove more classes of
@@ -238,20 +336,27 @@ impl MeshBoolImpl {
             first_new_vert,
         };
 
-        s.run(nb_edges, se, |myself, i| {
+        s.run(&edges, se, |myself, i| {
+            let num_vert = worklist.before_collapse(myself, i);
             let did_collapse = myself.collapse_edge(i as i32, &mut scratch_buffer);
             if did_collapse {
                 num_flagged += 1;
             }
             scratch_buffer.truncate(0);
+            worklist.after_collapse(myself, num_vert);
         });
+        worklist.update(self);
     }
 
-    fn collapse_colinear_edges(&mut self, first_new_vert: i32) {
+    fn collapse_colinear_edges(
+        &mut self,
+        first_new_vert: i32,
+        worklist: &mut Worklist,
+    ) {
         let mut s = FlagStore::default();
-        let nb_edges = self.halfedge.len();
         let mut scratch_buffer = Vec::with_capacity(10);
         loop {
+            let edges = worklist.edges(self, false);
             //CollapseFlaggedEdge
             let mut num_flagged = 0;
             // Collapse colinear edges, but only remove new verts, i.e. verts with
@@ -265,13 +370,16 @@ impl MeshBoolImpl {
                 first_new_vert,
             };
 
-            s.run(nb_edges, se, |myself, i| {
+            s.run(&edges, se, |myself, i| {
+                let num_vert = worklist.before_collapse(myself, i);
                 let did_collapse = myself.collapse_edge(i as i32, &mut scratch_buffer);
                 if did_collapse {
                     num_flagged += 1;
                 }
                 scratch_buffer.truncate(0);
+                worklist.after_collapse(myself, num_vert);
             });
+            worklist.update(self);
 
             if num_flagged == 0 {
                 break;
@@ -279,11 +387,11 @@ impl MeshBoolImpl {
         }
     }
 
-    fn swap_degenerates(&mut self, first_new_vert: i32) {
+    fn swap_degenerates(&mut self, first_new_vert: i32, worklist: &Worklist) {
         //RecursiveEdgeSwap
         let mut s = FlagStore::default();
         let mut num_flagged = 0;
-        let nb_edges = self.halfedge.len();
+        let edges = worklist.edges(self, true);
         let mut scratch_buffer = Vec::with_capacity(10);
 
         let tolerance = self.tolerance;
@@ -297,7 +405,7 @@ impl MeshBoolImpl {
         let mut edge_swap_stack = Vec::new();
         let mut visited = vec![-1; he_len];
         let mut tag = 0;
-        s.run(nb_edges, se, |myself, i| {
+        s.run(&edges, se, |myself, i| {
             num_flagged += 1;
             tag += 1;
             myself.recursive_edge_swap(
@@ -594,7 +702,6 @@ impl MeshBoolImpl {
         }
 
         let end_vert = to_remove.end_vert;
-        let tri0_edge = tri_of(edge);
         let tri1_edge = tri_of(to_remove.paired_halfedge);
 
         let p_new = self.vert_pos[end_vert as usize];
@@ -603,7 +710,7 @@ impl MeshBoolImpl {
         let short_edge = delta.magnitude_squared() < self.epsilon.powi(2);
 
         // Orbit startVert
-        let mut start = self.halfedge[tri1_edge[1] as usize].paired_halfedge;
+        let start = self.halfedge[tri1_edge[1] as usize].paired_halfedge;
         if !short_edge {
             let mut current = start;
             let mut ref_check =
@@ -661,6 +768,20 @@ impl MeshBoolImpl {
             }
         }
 
+        self.apply_collapse(edge, edges);
+        true
+    }
+
+    ///Collapses the given edge by removing startVert without checking whether
+    ///the result is geometrically acceptable, which is up to the caller. edges is
+    ///scratch space.
+    pub(crate) fn apply_collapse(&mut self, edge: i32, edges: &mut Vec<i32>) {
+        let to_remove = self.halfedge[edge as usize];
+        let end_vert = to_remove.end_vert;
+        let tri0_edge = tri_of(edge);
+        let tri1_edge = tri_of(to_remove.paired_halfedge);
+        let mut start = self.halfedge[tri1_edge[1] as usize].paired_halfedge;
+
         // Orbit endVert
         {
             let mut current = self.halfedge[tri0_edge[1] as usize].paired_halfedge;
@@ -713,7 +834,6 @@ impl MeshBoolImpl {
         self.update_vert(end_vert, start, tri0_edge[2]);
         self.collapse_tri(&tri0_edge);
         self.remove_if_folded(start);
-        true
     }
 
     fn recursive_edge_swap(
@@ -859,153 +979,210 @@ impl MeshBoolImpl {
         ]);
     }
 
+    ///Gives each vertex fan (the halfedges reachable from one another with
+    ///for_vert) its own vert. A vert with more than one fan is pinched; its
+    ///first fan in halfedge order keeps it and the others get new verts at the
+    ///same position, numbered in the order of their first halfedge.
     fn split_pinched_verts(&mut self) {
         let nb_edges = self.halfedge.len();
-
-        {
-            let mut vert_processed = vec![false; self.num_vert()];
-            let mut halfedge_processed = vec![false; nb_edges];
-            for i in 0..nb_edges {
-                if halfedge_processed[i] {
-                    continue;
-                }
-                let mut vert = self.halfedge[i].start_vert;
-                if vert == -1 {
-                    continue;
-                }
-                if vert_processed[vert as usize] {
-                    self.vert_pos.push(self.vert_pos[vert as usize]);
-                    vert = (self.num_vert() - 1) as i32;
-                } else {
-                    vert_processed[vert as usize] = true;
-                }
-
-                self.for_vert_mut(i as i32, |myself, current| {
-                    let current = current as usize;
-                    halfedge_processed[current] = true;
-                    myself.halfedge[current].start_vert = vert;
-                    let edge_i = myself.halfedge[current].paired_halfedge as usize;
-                    myself.halfedge[edge_i].end_vert = vert;
-                });
+        let num_vert = self.num_vert();
+
+        // Label every halfedge with the lowest halfedge of its fan, its root.
+        let mut fan_root = vec![-1; nb_edges];
+        let mut roots = Vec::new();
+        for i in 0..nb_edges {
+            if fan_root[i] >= 0 || self.halfedge[i].start_vert == -1 {
+                continue;
             }
+            roots.push(i);
+            self.for_vert(i as i32, |current| fan_root[current as usize] = i as i32);
         }
-    }
 
-    fn dedupe_edges(&mut self) {
-        loop {
-            //DedupeEdge
+        // A fan is a duplicate if an earlier one has the same vert. If there
+        // are none, nothing is pinched and nothing needs rewriting.
+        let mut vert_seen = vec![false; num_vert];
+        let is_duplicate: Vec<bool> = roots
+            .iter()
+            .map(|&root| {
+                let vert = self.halfedge[root].start_vert as usize;
+                mem::replace(&mut vert_seen[vert], true)
+            })
+            .collect();
+        let mut duplicate_idx: Vec<usize> = is_duplicate.iter().map(|&d| d as usize).collect();
+        let num_duplicate = duplicate_idx.iter().sum::<usize>();
+        if num_duplicate == 0 {
+            return;
+        }
+        exclusive_scan_in_place(&mut duplicate_idx, 0);
 
-            let nb_edges = self.halfedge.len();
-            let mut duplicates = Vec::<usize>::new();
-            let local_loop =
-                |start: usize, end: usize, local: &mut Vec<bool>, results: &mut Vec<usize>| {
-                    // Iterate over all halfedges that start with the same vertex, and check
-                    // for halfedges with the same ending vertex.
-                    // Note: we use Vec and linear search when the number of neighbor is
-                    // small because unordered_set requires allocations and is expensive.
-                    // We switch to unordered_set when the number of neighbor is
-                    // larger to avoid making things quadratic.
-                    // We do it in two pass, the first pass to find the minimal halfedges with
-                    // the target start and end verts, the second pass flag all the duplicated
-                    // halfedges that are not having the minimal index as duplicates.
-                    // This ensures deterministic result.
-                    //
-                    // The local store is to store the processed halfedges, so to avoid
-                    // repetitive processing. Note that it only approximates the processed
-                    // halfedges because it is thread local.
-                    let mut end_verts: Vec<(i32, i32)> = Vec::new();
-                    let mut end_vert_set: HashMap<i32, i32> = HashMap::new();
-                    for i in start..end {
-                        if local[i]
-                            || self.halfedge[i].start_vert == -1
-                            || self.halfedge[i].end_vert == -1
-                        {
-                            continue;
-                        }
+        let mut new_vert = vec![-1; nb_edges];
+        for (i, &root) in roots.iter().enumerate() {
+            new_vert[root] = if is_duplicate[i] {
+                (num_vert + duplicate_idx[i]) as i32
+            } else {
+                self.halfedge[root].start_vert
+            };
+        }
 
-                        // we want to keep the allocation
-                        end_verts.clear();
-                        end_vert_set.clear();
-
-                        // first iteration, populate entries
-                        // this makes sure we always report the same set of entries
-                        self.for_vert(i as i32, |current| {
-                            local[current as usize] = true;
-                            if self.halfedge[current as usize].start_vert == -1
-                                || self.halfedge[current as usize].end_vert == -1
-                            {
-                                return;
-                            }
-
-                            let end_v = self.halfedge[current as usize].end_vert;
-                            if end_vert_set.is_empty() {
-                                let iter = end_verts.iter_mut().find(|pair| pair.0 == end_v);
-
-                                if let Some(iter) = iter {
-                                    iter.1 = iter.1.min(current);
-                                } else {
-                                    end_verts.push((end_v, current));
-                                    if end_verts.len() > 32 {
-                                        for &(k, v) in end_verts.iter() {
-                                            end_vert_set.entry(k).or_insert(v);
-                                        }
-
-                                        end_verts.clear();
-                                    }
-                                }
-                            } else {
-                                let pair = match end_vert_set.entry(end_v) {
-                                    Entry::Vacant(entry) => (entry.insert(current), true),
-                                    Entry::Occupied(entry) => (entry.into_mut(), false),
-                                };
-
-                                if !pair.1 {
-                                    *pair.0 = (*pair.0).min(current);
-                                }
-                            }
-                        });
-
-                        // second iteration, actually check for duplicates
-                        // we always report the same set of duplicates, excluding the smallest
-                        // halfedge in the set of duplicates
-                        self.for_vert(i as i32, |current| {
-                            if self.halfedge[current as usize].start_vert == -1
-                                || self.halfedge[current as usize].end_vert == -1
-                            {
-                                return;
-                            }
-
-                            let end_v = self.halfedge[current as usize].end_vert;
-                            if end_vert_set.is_empty() {
-                                let iter = end_verts.iter().find(|pair| pair.0 == end_v).unwrap();
-
-                                if iter.1 != current {
-                                    results.push(current as usize);
-                                }
-                            } else {
-                                let iter = *end_vert_set.get(&end_v).unwrap();
-                                if iter != current {
-                                    results.push(current as usize);
-                                }
-                            }
-                        });
-                    }
-                };
+        self.vert_pos.reserve(num_duplicate);
+        for &root in &roots {
+            if new_vert[root] >= num_vert as i32 {
+                self.vert_pos
+                    .push(self.vert_pos[self.halfedge[root].start_vert as usize]);
+            }
+        }
+
+        for edge in 0..nb_edges {
+            if fan_root[edge] < 0 {
+                continue;
+            }
+            let pair = self.halfedge[edge].paired_halfedge as usize;
+            self.halfedge[edge].start_vert = new_vert[fan_root[edge] as usize];
+            self.halfedge[edge].end_vert = new_vert[fan_root[pair] as usize];
+        }
+    }
 
-            {
-                let mut local = vec![false; nb_edges];
-                local_loop(0, nb_edges, &mut local, &mut duplicates);
+    ///Returns the halfedges that duplicate another one with the same start and
+    ///end verts, i.e. all but the lowest-indexed of each set, in order of
+    ///(startVert, endVert, halfedge). The halfedges are bucketed by startVert with
+    ///a counting sort, so only each vertex's small fan needs comparing.
+    fn duplicate_edges(&self) -> Vec<usize> {
+        let num_vert = self.num_vert();
+        let is_live = |h: &Halfedge| h.start_vert >= 0 && h.end_vert >= 0;
+
+        let mut fan_start = vec![0; num_vert + 1];
+        for h in self.halfedge.iter().filter(|h| is_live(h)) {
+            fan_start[h.start_vert as usize] += 1;
+        }
+        exclusive_scan_in_place(&mut fan_start, 0);
+
+        let mut fill = fan_start.clone();
+        let mut fans = vec![0; fan_start[num_vert]];
+        for (edge, h) in self.halfedge.iter().enumerate() {
+            if is_live(h) {
+                let slot = &mut fill[h.start_vert as usize];
+                fans[*slot] = edge;
+                *slot += 1;
             }
+        }
 
-            let mut num_flagged = 0;
-            for i in duplicates {
-                self.dedupe_edge(i as i32);
-                num_flagged += 1;
+        let mut duplicates = Vec::new();
+        for vert in 0..num_vert {
+            let fan = &mut fans[fan_start[vert]..fan_start[vert + 1]];
+            if fan.len() < 2 {
+                continue;
             }
+            // Already in halfedge order, so a stable sort gives (endVert, halfedge).
+            fan.sort_by_key(|&edge| self.halfedge[edge].end_vert);
+            for pair in fan.windows(2) {
+                if self.halfedge[pair[0]].end_vert == self.halfedge[pair[1]].end_vert {
+                    duplicates.push(pair[1]);
+                }
+            }
+        }
+        duplicates
+    }
 
-            if num_flagged == 0 {
+    fn dedupe_edges(&mut self) {
+        loop {
+            //DedupeEdge
+            let duplicates = self.duplicate_edges();
+            if duplicates.is_empty() {
                 break;
             }
+
+            for edge in duplicates {
+                self.dedupe_edge(edge as i32);
+            }
         }
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    ///Two tetrahedra that share only the edge between verts 0 and 1, which
+    ///makes it 4-manifold.
+    fn bowtie() -> MeshBoolImpl {
+        let mut mesh = MeshBoolImpl::default();
+        mesh.vert_pos = vec![
+            Point3::new(0.0, 0.0, 0.0),
+            Point3::new(0.0, 0.0, 1.0),
+            Point3::new(1.0, 0.0, 0.5),
+            Point3::new(1.0, 1.0, 0.5),
+            Point3::new(-1.0, 0.0, 0.5),
+            Point3::new(-1.0, -1.0, 0.5),
+        ];
+        let tris = vec![
+            Vector3::new(0, 1, 2),
+            Vector3::new(0, 2, 3),
+            Vector3::new(0, 3, 1),
+            Vector3::new(1, 3, 2),
+            Vector3::new(0, 1, 4),
+            Vector3::new(0, 4, 5),
+            Vector3::new(0, 5, 1),
+            Vector3::new(1, 5, 4),
+        ];
+        mesh.create_halfedges(tris.clone(), tris);
+        mesh
+    }
+
+    #[test]
+    fn dedupe_splits_4_manifold_edge() {
+        let mut mesh = bowtie();
+        assert!(mesh.is_manifold());
+        assert!(!mesh.is_2_manifold());
+        assert_eq!(mesh.duplicate_edges().len(), 2);
+
+        mesh.cleanup_topology();
+        assert!(mesh.is_2_manifold());
+        assert!(mesh.duplicate_edges().is_empty());
+        assert_eq!(mesh.num_vert(), 8);
+    }
+
+    #[test]
+    fn split_pinched_vert() {
+        // Two tetrahedra that share only vert 0.
+        let mut mesh = MeshBoolImpl::default();
+        mesh.vert_pos = vec![
+            Point3::new(0.0, 0.0, 0.0),
+            Point3::new(1.0, 0.0, 0.0),
+            Point3::new(1.0, 1.0, 0.0),
+            Point3::new(1.0, 0.0, 1.0),
+            Point3::new(-1.0, 0.0, 0.0),
+            Point3::new(-1.0, -1.0, 0.0),
+            Point3::new(-1.0, 0.0, -1.0),
+        ];
+        let tris = vec![
+            Vector3::new(0, 2, 1),
+            Vector3::new(0, 1, 3),
+            Vector3::new(0, 3, 2),
+            Vector3::new(1, 2, 3),
+            Vector3::new(0, 5, 4),
+            Vector3::new(0, 4, 6),
+            Vector3::new(0, 6, 5),
+            Vector3::new(4, 5, 6),
+        ];
+        mesh.create_halfedges(tris.clone(), tris);
+        assert!(mesh.is_2_manifold());
+
+        mesh.split_pinched_verts();
+        assert!(mesh.is_2_manifold());
+        assert_eq!(mesh.num_vert(), 8);
+        assert_eq!(mesh.vert_pos[7], mesh.vert_pos[0]);
+        let verts = |edges: &[Halfedge]| -> Vec<i32> {
+            edges.iter().flat_map(|h| [h.start_vert, h.end_vert]).collect()
+        };
+        assert!(verts(&mesh.halfedge[..12]).contains(&0));
+        assert!(!verts(&mesh.halfedge[..12]).contains(&7));
+        assert!(verts(&mesh.halfedge[12..]).contains(&7));
+        assert!(!verts(&mesh.halfedge[12..]).contains(&0));
+
+        // Without pinches it is a no-op.
+        let before = verts(&mesh.halfedge);
+        mesh.split_pinched_verts();
+        assert_eq!(mesh.num_vert(), 8);
+        assert_eq!(verts(&mesh.halfedge), before);
+    }
+}
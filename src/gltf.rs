@@ -0,0 +1,590 @@
+use crate::meshboolimpl::MeshBoolImpl;
+use crate::{MeshGL, get_mesh_gl};
+use std::fmt::Write as _;
+use std::io::{self, Read, Write};
+
+const GLB_MAGIC: u32 = 0x46546C67;
+const CHUNK_JSON: u32 = 0x4E4F534A;
+const CHUNK_BIN: u32 = 0x004E4942;
+const FLOAT: u32 = 5126;
+const UNSIGNED_INT: u32 = 5125;
+const EXTENSION: &str = "EXT_mesh_manifold";
+///Deeper JSON is rejected rather than overflowing the stack; glTF itself
+///nests only a few levels.
+const MAX_JSON_DEPTH: usize = 64;
+
+fn invalid(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, format!("invalid glTF: {msg}"))
+}
+
+///Just enough of JSON to read the glTF this library writes, and most others.
+#[derive(Clone, Debug, PartialEq)]
+enum Json {
+    Null,
+    Bool(bool),
+    Number(f64),
+    String(String),
+    Array(Vec<Json>),
+    Object(Vec<(String, Json)>),
+}
+
+impl Json {
+    fn get(&self, key: &str) -> Option<&Json> {
+        match self {
+            Json::Object(members) => members.iter().find(|(k, _)| k == key).map(|(_, v)| v),
+            _ => None,
+        }
+    }
+
+    fn array(&self) -> &[Json] {
+        match self {
+            Json::Array(items) => items,
+            _ => &[],
+        }
+    }
+
+    ///The value as an index or size. Above 2^53 doubles are no longer exact
+    ///integers, so such values are rejected rather than saturated.
+    fn usize(&self) -> Option<usize> {
+        match *self {
+            Json::Number(x) if x >= 0.0 && x.fract() == 0.0 && x <= (1u64 << 53) as f64 => {
+                usize::try_from(x as u64).ok()
+            }
+            _ => None,
+        }
+    }
+
+    ///The non-negative integer at key, or an error naming it.
+    fn index(&self, key: &str) -> io::Result<usize> {
+        self.get(key)
+            .and_then(Json::usize)
+            .ok_or_else(|| invalid(&format!("missing {key}")))
+    }
+}
+
+struct Parser<'a> {
+    text: &'a [u8],
+    pos: usize,
+    // values currently being parsed, i.e. the nesting depth
+    depth: usize,
+}
+
+impl<'a> Parser<'a> {
+    fn skip_space(&mut self) {
+        while self.pos < self.text.len() && self.text[self.pos].is_ascii_whitespace() {
+            self.pos += 1;
+        }
+    }
+
+    fn expect(&mut self, byte: u8) -> io::Result<()> {
+        self.skip_space();
+        if self.text.get(self.pos) != Some(&byte) {
+            return Err(invalid(&format!("expected '{}' in JSON", byte as char)));
+        }
+        self.pos += 1;
+        Ok(())
+    }
+
+    fn string(&mut self) -> io::Result<String> {
+        self.expect(b'"')?;
+        let mut out = Vec::new();
+        loop {
+            let byte = *self.text.get(self.pos).ok_or_else(|| invalid("unterminated string"))?;
+            self.pos += 1;
+            match byte {
+                b'"' => break,
+                b'\\' => {
+                    let escape = *self.text.get(self.pos).ok_or_else(|| invalid("bad escape"))?;
+                    self.pos += 1;
+                    let unescaped = match escape {
+                        b'b' => '\u{8}',
+                        b'f' => '\u{c}',
+                        b'n' => '\n',
+                        b'r' => '\r',
+                        b't' => '\t',
+                        b'u' => {
+                            let hex = self.text.get(self.pos..self.pos + 4);
+                            let code = hex
+                                .and_then(|hex| std::str::from_utf8(hex).ok())
+                                .and_then(|hex| u32::from_str_radix(hex, 16).ok())
+                                .ok_or_else(|| invalid("bad escape"))?;
+                            self.pos += 4;
+                            char::from_u32(code).unwrap_or('\u{fffd}')
+                        }
+                        other => other as char,
+                    };
+                    out.extend_from_slice(unescaped.encode_utf8(&mut [0; 4]).as_bytes());
+                }
+                _ => out.push(byte),
+            }
+        }
+        String::from_utf8(out).map_err(|_| invalid("string is not UTF-8"))
+    }
+
+    fn value(&mut self) -> io::Result<Json> {
+        if self.depth == MAX_JSON_DEPTH {
+            return Err(invalid("JSON nested too deeply"));
+        }
+        self.depth += 1;
+        let value = self.value_inner();
+        self.depth -= 1;
+        value
+    }
+
+    fn value_inner(&mut self) -> io::Result<Json> {
+        self.skip_space();
+        match self.text.get(self.pos) {
+            Some(b'{') => {
+                self.pos += 1;
+                let mut members = Vec::new();
+                self.skip_space();
+                if self.text.get(self.pos) == Some(&b'}') {
+                    self.pos += 1;
+                    return Ok(Json::Object(members));
+                }
+                loop {
+                    let key = self.string()?;
+                    self.expect(b':')?;
+                    members.push((key, self.value()?));
+                    self.skip_space();
+                    self.pos += 1;
+                    match self.text.get(self.pos - 1) {
+                        Some(b',') => {}
+                        Some(b'}') => return Ok(Json::Object(members)),
+                        _ => return Err(invalid("expected ',' or '}' in JSON")),
+                    }
+                }
+            }
+            Some(b'[') => {
+                self.pos += 1;
+                let mut items = Vec::new();
+                self.skip_space();
+                if self.text.get(self.pos) == Some(&b']') {
+                    self.pos += 1;
+                    return Ok(Json::Array(items));
+                }
+                loop {
+                    items.push(self.value()?);
+                    self.skip_space();
+                    self.pos += 1;
+                    match self.text.get(self.pos - 1) {
+                        Some(b',') => {}
+                        Some(b']') => return Ok(Json::Array(items)),
+                        _ => return Err(invalid("expected ',' or ']' in JSON")),
+                    }
+                }
+            }
+            Some(b'"') => Ok(Json::String(self.string()?)),
+            Some(_) => {
+                let start = self.pos;
+                while self.pos < self.text.len()
+                    && !b",]} \t\r\n".contains(&self.text[self.pos])
+                {
+                    self.pos += 1;
+                }
+                let token = std::str::from_utf8(&self.text[start..self.pos]).unwrap_or("");
+                match token {
+                    "null" => Ok(Json::Null),
+                    "true" => Ok(Json::Bool(true)),
+                    "false" => Ok(Json::Bool(false)),
+                    _ => token.parse().map(Json::Number).map_err(|_| invalid("bad JSON value")),
+                }
+            }
+            None => Err(invalid("unexpected end of JSON")),
+        }
+    }
+}
+
+fn parse_json(text: &[u8]) -> io::Result<Json> {
+    let mut parser = Parser {
+        text,
+        pos: 0,
+        depth: 0,
+    };
+    let value = parser.value()?;
+    parser.skip_space();
+    if parser.pos != text.len() {
+        return Err(invalid("trailing data after JSON"));
+    }
+    Ok(value)
+}
+
+///Reads the elements of an accessor as f64, as a flat array of count times the
+///number of components.
+fn read_accessor(gltf: &Json, bin: &[u8], accessor: usize) -> io::Result<Vec<f64>> {
+    let accessor = gltf
+        .get("accessors")
+        .and_then(|a| a.array().get(accessor))
+        .ok_or_else(|| invalid("accessor out of bounds"))?;
+    if accessor.get("sparse").is_some() {
+        return Err(invalid("sparse accessors are not supported"));
+    }
+    let count = accessor.index("count")?;
+    let components = match accessor.get("type") {
+        Some(Json::String(kind)) => match kind.as_str() {
+            "SCALAR" => 1,
+            "VEC2" => 2,
+            "VEC3" => 3,
+            "VEC4" => 4,
+            _ => return Err(invalid("unsupported accessor type")),
+        },
+        _ => return Err(invalid("missing accessor type")),
+    };
+    let component_type = accessor.index("componentType")?;
+    let (size, read): (usize, fn(&[u8]) -> f64) = match component_type {
+        5121 => (1, |b| b[0] as f64),
+        5123 => (2, |b| u16::from_le_bytes([b[0], b[1]]) as f64),
+        5125 => (4, |b| u32::from_le_bytes(b[..4].try_into().unwrap()) as f64),
+        5126 => (4, |b| f32::from_le_bytes(b[..4].try_into().unwrap()) as f64),
+        _ => return Err(invalid("unsupported component type")),
+    };
+
+    let view = accessor.index("bufferView")?;
+    let view = gltf
+        .get("bufferViews")
+        .and_then(|v| v.array().get(view))
+        .ok_or_else(|| invalid("buffer view out of bounds"))?;
+    if view.get("buffer").and_then(Json::usize) != Some(0) {
+        return Err(invalid("only the GLB binary buffer is supported"));
+    }
+    let element = components * size;
+    let stride = view.get("byteStride").and_then(Json::usize).unwrap_or(element);
+    if stride < element {
+        return Err(invalid("byteStride is smaller than an element"));
+    }
+    // All of these come from the file, so overflow means out of bounds.
+    let view_start = view.get("byteOffset").and_then(Json::usize).unwrap_or(0);
+    let offset = accessor.get("byteOffset").and_then(Json::usize).unwrap_or(0);
+    let start = view_start.checked_add(offset);
+    let view_end = view_start.checked_add(view.index("byteLength")?);
+    let end = match count {
+        0 => start,
+        _ => start
+            .and_then(|start| start.checked_add(stride.checked_mul(count - 1)?))
+            .and_then(|end| end.checked_add(element)),
+    };
+    let (Some(start), Some(end), Some(view_end)) = (start, end, view_end) else {
+        return Err(invalid("accessor exceeds its buffer"));
+    };
+    if end > view_end || view_end > bin.len() {
+        return Err(invalid("accessor exceeds its buffer"));
+    }
+
+    let mut out = Vec::with_capacity(count * components);
+    for i in 0..count {
+        let bytes = &bin[start + i * stride..start + i * stride + element];
+        out.extend(bytes.chunks_exact(size).map(read));
+    }
+    Ok(out)
+}
+
+impl MeshBoolImpl {
+    pub(crate) fn write_glb<W: Write>(&self, normal_idx: i32, writer: &mut W) -> io::Result<()> {
+        let mesh = get_mesh_gl(self, normal_idx);
+        let num_prop = mesh.num_prop as usize;
+        let num_vert = mesh.vert_properties.len() / num_prop;
+        if mesh.tri_verts.is_empty() {
+            return Err(io::Error::new(io::ErrorKind::InvalidInput, "empty manifold"));
+        }
+        if 4 * num_prop > 252 {
+            return Err(io::Error::new(io::ErrorKind::InvalidInput, "too many properties"));
+        }
+        glb(&mesh, num_vert, normal_idx, writer)
+    }
+
+    pub(crate) fn read_glb<R: Read>(mut reader: R) -> io::Result<MeshBoolImpl> {
+        let mut data = Vec::new();
+        reader.read_to_end(&mut data)?;
+        let word = |i: usize| {
+            let bytes = data.get(4 * i..4 * i + 4)?;
+            Some(u32::from_le_bytes(bytes.try_into().unwrap()))
+        };
+        if word(0) != Some(GLB_MAGIC) || word(1) != Some(2) {
+            return Err(invalid("not a GLB version 2 file"));
+        }
+
+        // The JSON chunk comes first, then optionally the binary one.
+        let mut chunks = Vec::new();
+        let mut pos = 12;
+        while pos + 8 <= data.len() {
+            let length = word(pos / 4).unwrap() as usize;
+            let kind = word(pos / 4 + 1).unwrap();
+            let body = data.get(pos + 8..pos + 8 + length).ok_or_else(|| invalid("truncated"))?;
+            chunks.push((kind, body));
+            pos += 8 + length.div_ceil(4) * 4;
+        }
+        let json = match chunks.first() {
+            Some(&(CHUNK_JSON, body)) => body,
+            _ => return Err(invalid("missing JSON chunk")),
+        };
+        let bin = match chunks.get(1) {
+            Some(&(CHUNK_BIN, body)) => body,
+            _ => &[][..],
+        };
+        let gltf = parse_json(json)?;
+        from_gltf(&gltf, bin)
+    }
+}
+
+///Builds the manifold from the first mesh. Its primitives each become a run,
+///and the float attributes shared by all of them, in the order of the first,
+///become property channels after the position.
+fn from_gltf(gltf: &Json, bin: &[u8]) -> io::Result<MeshBoolImpl> {
+    let mesh = gltf
+        .get("meshes")
+        .and_then(|m| m.array().first())
+        .ok_or_else(|| invalid("no meshes"))?;
+    let primitives = mesh.get("primitives").map(Json::array).unwrap_or(&[]);
+    let first = primitives.first().ok_or_else(|| invalid("no primitives"))?;
+    for primitive in primitives {
+        if primitive.get("mode").is_some_and(|mode| mode.usize() != Some(4)) {
+            return Err(invalid("only triangle primitives are supported"));
+        }
+    }
+
+    let is_float = |accessor: usize| {
+        gltf.get("accessors")
+            .and_then(|a| a.array().get(accessor))
+            .and_then(|a| a.get("componentType"))
+            .and_then(Json::usize)
+            == Some(FLOAT as usize)
+    };
+    let attribute = |primitive: &Json, name: &str| {
+        primitive.get("attributes").and_then(|a| a.get(name)).and_then(Json::usize)
+    };
+    let channels: Vec<&str> = match first.get("attributes") {
+        Some(Json::Object(members)) => members
+            .iter()
+            .map(|(name, _)| name.as_str())
+            .filter(|&name| name != "POSITION")
+            .filter(|&name| {
+                primitives
+                    .iter()
+                    .all(|p| attribute(p, name).is_some_and(|accessor| is_float(accessor)))
+            })
+            .collect(),
+        _ => Vec::new(),
+    };
+
+    // Primitives that share their attributes share their verts.
+    let mut mesh_gl = MeshGL::default();
+    // (POSITION accessor, first vert, vert count) of each vertex set.
+    let mut vert_sets: Vec<(usize, usize, usize)> = Vec::new();
+    let mut run_tris: Vec<usize> = Vec::new();
+    let mut tri_verts: Vec<u32> = Vec::new();
+    for primitive in primitives {
+        let position = attribute(primitive, "POSITION").ok_or_else(|| invalid("no POSITION"))?;
+        let (base, num_vert) = match vert_sets.iter().find(|set| set.0 == position) {
+            Some(&(_, base, num_vert)) => (base, num_vert),
+            None => {
+                let positions = read_accessor(gltf, bin, position)?;
+                let mut props: Vec<(Vec<f64>, usize)> = Vec::new();
+                let num_vert = positions.len() / 3;
+                for &name in &channels {
+                    let values = read_accessor(gltf, bin, attribute(primitive, name).unwrap())?;
+                    let width = values.len() / num_vert.max(1);
+                    if values.len() != width * num_vert {
+                        return Err(invalid("attribute counts differ"));
+                    }
+                    props.push((values, width));
+                }
+                let base = mesh_gl.vert_properties.len();
+                let num_prop = 3 + props.iter().map(|(_, width)| width).sum::<usize>();
+                if mesh_gl.num_prop != 0 && mesh_gl.num_prop as usize != num_prop {
+                    return Err(invalid("attribute widths differ"));
+                }
+                mesh_gl.num_prop = num_prop as u32;
+                for vert in 0..num_vert {
+                    let pos = &positions[3 * vert..3 * vert + 3];
+                    mesh_gl.vert_properties.extend(pos.iter().map(|&x| x as f32));
+                    for (values, width) in &props {
+                        let value = &values[width * vert..width * (vert + 1)];
+                        mesh_gl.vert_properties.extend(value.iter().map(|&x| x as f32));
+                    }
+                }
+                let base = base / num_prop;
+                vert_sets.push((position, base, num_vert));
+                (base, num_vert)
+            }
+        };
+        let indices = match primitive.get("indices").and_then(Json::usize) {
+            Some(accessor) => read_accessor(gltf, bin, accessor)?,
+            None => (0..num_vert).map(|i| i as f64).collect(),
+        };
+        if indices.len() % 3 != 0 || indices.iter().any(|&i| i as usize >= num_vert) {
+            return Err(invalid("bad triangle indices"));
+        }
+        tri_verts.extend(indices.iter().map(|&i| (base + i as usize) as u32));
+        run_tris.push(indices.len());
+    }
+
+    // With the extension, the verts are already merged exactly as they were
+    // written, so no welding is needed.
+    let extension = mesh.get("extensions").and_then(|e| e.get(EXTENSION));
+    let mut is_merged = false;
+    if let Some(extension) = extension {
+        if vert_sets.len() == 1 {
+            let manifold = extension.get("manifoldPrimitive");
+            if let Some(accessor) = manifold.and_then(|p| p.get("indices")) {
+                let all = read_accessor(gltf, bin, accessor.usize().unwrap_or(usize::MAX))?;
+                if all.len() != tri_verts.len() {
+                    return Err(invalid("manifoldPrimitive does not match the primitives"));
+                }
+                tri_verts = all.iter().map(|&i| i as u32).collect();
+            }
+            let merge = |key: &str| match extension.get(key).and_then(Json::usize) {
+                Some(accessor) => read_accessor(gltf, bin, accessor),
+                None => Ok(Vec::new()),
+            };
+            mesh_gl.merge_from_vert = merge("mergeIndices")?.iter().map(|&i| i as u32).collect();
+            mesh_gl.merge_to_vert = merge("mergeValues")?.iter().map(|&i| i as u32).collect();
+            is_merged = true;
+        }
+    }
+
+    let first_id = MeshBoolImpl::reserve_ids(run_tris.len()) as u32;
+    mesh_gl.run_original_id = (first_id..first_id + run_tris.len() as u32).collect();
+    mesh_gl.run_index.push(0);
+    for len in run_tris {
+        mesh_gl.run_index.push(mesh_gl.run_index.last().unwrap() + len as u32);
+    }
+    mesh_gl.tri_verts = tri_verts;
+    if !is_merged {
+        mesh_gl.merge();
+    }
+    Ok(MeshBoolImpl::from_mesh_gl(&mesh_gl))
+}
+
+///Writes mesh as a GLB with one primitive per run, all sharing one interleaved
+///vertex buffer, and the EXT_mesh_manifold extension holding the complete index
+///list and the merge vectors.
+fn glb<W: Write>(
+    mesh: &MeshGL,
+    num_vert: usize,
+    normal_idx: i32,
+    writer: &mut W,
+) -> io::Result<()> {
+    let num_prop = mesh.num_prop as usize;
+    let vert_bytes = 4 * mesh.vert_properties.len();
+    let index_bytes = 4 * mesh.tri_verts.len();
+    let merge_bytes = 4 * mesh.merge_from_vert.len();
+    let bin_len = vert_bytes + index_bytes + 2 * merge_bytes;
+
+    let mut min = [f32::INFINITY; 3];
+    let mut max = [f32::NEG_INFINITY; 3];
+    for vert in mesh.vert_properties.chunks_exact(num_prop) {
+        for i in 0..3 {
+            min[i] = min[i].min(vert[i]);
+            max[i] = max[i].max(vert[i]);
+        }
+    }
+
+    let mut accessors: Vec<String> = Vec::new();
+    let mut accessor = |view: usize, offset: usize, component: u32, count: usize, kind: &str| {
+        accessors.push(format!(
+            "{{\"bufferView\":{view},\"byteOffset\":{offset},\"componentType\":{component},\
+             \"count\":{count},\"type\":\"{kind}\""
+        ));
+        accessors.len() - 1
+    };
+
+    // The normal channels form one attribute; every other one is a scalar.
+    let position = accessor(0, 0, FLOAT, num_vert, "VEC3");
+    let mut attributes = format!("\"POSITION\":{position}");
+    let mut channel = 0;
+    while channel < num_prop - 3 {
+        let offset = 4 * (3 + channel);
+        if channel as i32 == normal_idx && channel + 3 <= num_prop - 3 {
+            let idx = accessor(0, offset, FLOAT, num_vert, "VEC3");
+            write!(attributes, ",\"NORMAL\":{idx}").unwrap();
+            channel += 3;
+        } else {
+            let idx = accessor(0, offset, FLOAT, num_vert, "SCALAR");
+            write!(attributes, ",\"_PROPERTY_{channel}\":{idx}").unwrap();
+            channel += 1;
+        }
+    }
+
+    let mut primitives = Vec::new();
+    for run in 0..mesh.run_original_id.len() {
+        let (start, end) = (mesh.run_index[run] as usize, mesh.run_index[run + 1] as usize);
+        if start == end {
+            continue;
+        }
+        let indices = accessor(1, 4 * start, UNSIGNED_INT, end - start, "SCALAR");
+        let id = mesh.run_original_id[run];
+        primitives.push(format!(
+            "{{\"attributes\":{{{attributes}}},\"indices\":{indices},\"mode\":4,\
+             \"extras\":{{\"originalID\":{id}}}}}"
+        ));
+    }
+
+    let all = accessor(1, 0, UNSIGNED_INT, mesh.tri_verts.len(), "SCALAR");
+    let mut extension = format!("\"manifoldPrimitive\":{{\"indices\":{all},\"mode\":4}}");
+    let stride = 4 * num_prop;
+    let mut views = vec![
+        format!(
+            "{{\"buffer\":0,\"byteLength\":{vert_bytes},\"byteStride\":{stride},\
+             \"target\":34962}}"
+        ),
+        format!(
+            "{{\"buffer\":0,\"byteOffset\":{vert_bytes},\"byteLength\":{index_bytes},\
+             \"target\":34963}}"
+        ),
+    ];
+    if merge_bytes > 0 {
+        let count = mesh.merge_from_vert.len();
+        let from = accessor(2, 0, UNSIGNED_INT, count, "SCALAR");
+        let to = accessor(2, merge_bytes, UNSIGNED_INT, count, "SCALAR");
+        write!(extension, ",\"mergeIndices\":{from},\"mergeValues\":{to}").unwrap();
+        let offset = vert_bytes + index_bytes;
+        let length = 2 * merge_bytes;
+        views.push(format!("{{\"buffer\":0,\"byteOffset\":{offset},\"byteLength\":{length}}}"));
+    }
+    // Close each accessor, adding the bounds POSITION requires.
+    for (i, accessor) in accessors.iter_mut().enumerate() {
+        if i == position {
+            write!(accessor, ",\"min\":{min:?},\"max\":{max:?}").unwrap();
+        }
+        accessor.push('}');
+    }
+
+    let mut json = String::new();
+    json += "{\"asset\":{\"version\":\"2.0\",\"generator\":\"meshbool\"},";
+    write!(json, "\"extensionsUsed\":[\"{EXTENSION}\"],").unwrap();
+    json += "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],";
+    write!(json, "\"meshes\":[{{\"primitives\":[{}],", primitives.join(",")).unwrap();
+    write!(json, "\"extensions\":{{\"{EXTENSION}\":{{{extension}}}}}}}],").unwrap();
+    write!(json, "\"buffers\":[{{\"byteLength\":{bin_len}}}],").unwrap();
+    write!(json, "\"bufferViews\":[{}],", views.join(",")).unwrap();
+    write!(json, "\"accessors\":[{}]}}", accessors.join(",")).unwrap();
+    while json.len() % 4 != 0 {
+        json.push(' ');
+    }
+
+    let total = 12 + 8 + json.len() + 8 + bin_len.div_ceil(4) * 4;
+    let total = u32::try_from(total)
+        .map_err(|_| io::Error::new(io::ErrorKind::InvalidInput, "too large for GLB"))?;
+    let mut header = Vec::with_capacity(28);
+    for word in [GLB_MAGIC, 2, total, json.len() as u32, CHUNK_JSON] {
+        header.extend_from_slice(&word.to_le_bytes());
+    }
+    writer.write_all(&header)?;
+    writer.write_all(json.as_bytes())?;
+    writer.write_all(&(bin_len as u32).to_le_bytes())?;
+    writer.write_all(&CHUNK_BIN.to_le_bytes())?;
+
+    // Every value is a 4-byte word, so the binary chunk needs no padding.
+    let mut buffer: Vec<u8> = Vec::with_capacity(1 << 16);
+    let words = mesh.vert_properties.iter().map(|x| x.to_bits());
+    let words = words.chain(mesh.tri_verts.iter().copied());
+    let words = words.chain(mesh.merge_from_vert.iter().copied());
+    for word in words.chain(mesh.merge_to_vert.iter().copied()) {
+        buffer.extend_from_slice(&word.to_le_bytes());
+        if buffer.len() == buffer.capacity() {
+            writer.write_all(&buffer)?;
+            buffer.clear();
+        }
+    }
+    writer.write_all(&buffer)
+}
@@ -3,27 +3,42 @@ use crate::meshboolimpl::{MeshBoolImpl, Relation};
 use crate::shared::normal_transform;
 pub use crate::common::Aabb;
 pub use crate::common::OpType;
+pub use crate::common::{Polygons, SimplePolygon};
 pub use crate::meshboolimpl::MeshBoolImpl as Impl; // For backward compatibility
-use nalgebra::{Matrix3, Matrix3x4, Point3, UnitQuaternion, Vector2, Vector3};
+pub use crate::meshboolimpl::MemoryFootprint;
+pub use crate::obj::{ObjGroup, ObjLayout};
+pub use crate::polygon::Triangulator;
+use nalgebra::{Matrix3, Matrix3x4, Point3, UnitQuaternion, Vector3};
+use std::io::{self, Read, Write};
 use std::ops::{Add, AddAssign, BitXor, BitXorAssign, Sub, SubAssign};
 
 pub use constructors::*;
 
+#[cfg(feature = "alloc-stats")]
+pub mod alloc_stats;
 mod boolean3;
 mod boolean_result;
 mod collider;
 mod common;
 mod constructors;
+mod decimate;
 mod disjoint_sets;
 mod edge_op;
 mod face_op;
+mod gltf;
 pub mod meshboolimpl;
+mod merge;
 mod mesh_fixes;
+mod monotone;
+mod obj;
 mod parallel;
 mod polygon;
 mod properties;
 mod shared;
+mod snapshot;
 mod sort;
+mod stl;
+mod threemf;
 mod tree2d;
 mod utils;
 mod vec;
@@ -76,7 +91,7 @@ fn test() {
 ///manifold topology. These merges are simply a union, so which is from and to
 ///doesn't matter.
 ///
-///If you don't have merge vectors, you can create them with the Merge() method,
+///If you don't have merge vectors, you can create them with the merge() method,
 ///however this will fail if the mesh is not already manifold within the set
 ///tolerance. For maximum reliability, always store the merge vectors with the
 ///mesh, e.g. using the EXT_mesh_manifold extension in glTF.
@@ -117,24 +132,24 @@ fn test() {
 ///
 ///MeshGL is an alias for the standard single-precision version. Use MeshGL64 to
 ///output the full double precision that Manifold uses internally.
-#[derive(Debug)]
-pub struct MeshGL {
+#[derive(Clone, Debug, Default, PartialEq)]
+pub struct MeshGLP<P, I> {
     /// Number of properties per vertex, always >= 3.
     pub num_prop: u32,
     /// Flat, GL-style interleaved list of all vertex properties: propVal =
     /// vertProperties[vert * numProp + propIdx]. The first three properties are
     /// always the position x, y, z. The stride of the array is numProp.
-    pub vert_properties: Vec<f32>,
+    pub vert_properties: Vec<P>,
     /// The vertex indices of the three triangle corners in CCW (from the outside)
     /// order, for each triangle.
-    pub tri_verts: Vec<u32>,
+    pub tri_verts: Vec<I>,
     /// Optional: A list of only the vertex indicies that need to be merged to
     /// reconstruct the manifold.
-    pub merge_from_vert: Vec<u32>,
+    pub merge_from_vert: Vec<I>,
     /// Optional: The same length as mergeFromVert, and the corresponding value
     /// contains the vertex to merge with. It will have an identical position, but
     /// the other properties may differ.
-    pub merge_to_vert: Vec<u32>,
+    pub merge_to_vert: Vec<I>,
     /// Optional: Indicates runs of triangles that correspond to a particular
     /// input mesh instance. The runs encompass all of triVerts and are sorted
     /// by runOriginalID. Run i begins at triVerts[runIndex[i]] and ends at
@@ -142,7 +157,7 @@ pub struct MeshGL {
     /// runIndex will always be 1 longer than runOriginalID, but same length is
     /// also allowed as input: triVerts.size() will be automatically appended in
     /// this case.
-    pub run_index: Vec<u32>,
+    pub run_index: Vec<I>,
     /// Optional: The OriginalID of the mesh this triangle run came from. This ID
     /// is ideal for reapplying materials to the output mesh. Multiple runs may
     /// have the same ID, e.g. representing different copies of the same input
@@ -153,18 +168,84 @@ pub struct MeshGL {
     /// corresponding original mesh was transformed to create this triangle run.
     /// This matrix is stored in column-major order and the length of the overall
     /// vector is 12 * runOriginalID.size().
-    pub run_transform: Vec<f32>,
+    pub run_transform: Vec<P>,
     /// Optional: Length NumTri, contains the source face ID this triangle comes
     /// from. Simplification will maintain all edges between triangles with
     /// different faceIDs. Input faceIDs will be maintained to the outputs, but if
     /// none are given, they will be filled in with Manifold's coplanar face
     /// calculation based on mesh tolerance.
-    pub face_id: Vec<u32>,
+    pub face_id: Vec<I>,
     /// Tolerance for mesh simplification. When creating a Manifold, the tolerance
     /// used will be the maximum of this and a baseline tolerance from the size of
     /// the bounding box. Any edge shorter than tolerance may be collapsed.
     /// Tolerance may be enlarged when floating point error accumulates.
-    pub tolerance: f32,
+    pub tolerance: P,
+}
+
+///Single-precision MeshGL, matching the float buffers of graphics APIs.
+pub type MeshGL = MeshGLP<f32, u32>;
+///Double-precision MeshGL, carrying the positions and properties exactly as
+///they are stored internally.
+pub type MeshGL64 = MeshGLP<f64, u64>;
+
+///The floating-point type of a MeshGLP's properties, transforms and tolerance.
+pub trait Precision: Copy + Default + PartialEq + std::fmt::Debug {
+    ///The relative precision the baseline tolerance is scaled from.
+    const EPSILON: f64;
+    fn from_f64(x: f64) -> Self;
+    fn to_f64(self) -> f64;
+}
+
+impl Precision for f32 {
+    const EPSILON: f64 = f32::EPSILON as f64;
+    #[inline]
+    fn from_f64(x: f64) -> Self {
+        x as f32
+    }
+    #[inline]
+    fn to_f64(self) -> f64 {
+        self as f64
+    }
+}
+
+impl Precision for f64 {
+    const EPSILON: f64 = utils::K_PRECISION;
+    #[inline]
+    fn from_f64(x: f64) -> Self {
+        x
+    }
+    #[inline]
+    fn to_f64(self) -> f64 {
+        self
+    }
+}
+
+///The integer type of a MeshGLP's vertex and triangle indices.
+pub trait Index: Copy + Default + Eq + Ord + std::fmt::Debug {
+    fn from_usize(x: usize) -> Self;
+    fn to_usize(self) -> usize;
+}
+
+impl Index for u32 {
+    #[inline]
+    fn from_usize(x: usize) -> Self {
+        x as u32
+    }
+    #[inline]
+    fn to_usize(self) -> usize {
+        self as usize
+    }
+}
+
+impl Index for u64 {
+    #[inline]
+    fn from_usize(x: usize) -> Self {
+        x as u64
+    }
+    #[inline]
+    fn to_usize(self) -> usize {
+        self as usize
+    }
 }
 
 fn invalid() -> MeshBoolImpl {
@@ -306,6 +387,14 @@ impl BitXorAssign<&Self> for MeshBoolImpl {
 pub enum ManifoldError {
     NoError,
     NonFiniteVertex,
+    NotManifold,
+    VertexOutOfBounds,
+    MissingPositionProperties,
+    MergeVectorsDifferentLengths,
+    MergeIndexOutOfBounds,
+    TransformWrongLength,
+    RunIndexWrongLength,
+    FaceIdWrongLength,
     InvalidConstruction,
     ResultTooLarge,
 }
@@ -503,6 +592,213 @@ pub fn smooth(r#impl: &MeshBoolImpl, tolerance: f64) -> MeshBoolImpl {
     result
 }
 
+///Decimate functionality - reduces the triangle count of a mesh.
+///Edges are collapsed in order of increasing quadric error, i.e. the sum of
+///squared distances to the planes of the original triangles around them, until
+///at most target_tris triangles remain or the next collapse would move the
+///surface by more than max_error. Pass 0 or f64::INFINITY respectively to
+///only use the other limit.
+///
+///Collapses never cross a boundary between faces (face_id) or a property
+///seam; verts on such boundaries only slide along them, and corners where more
+///than two faces meet are kept. Every remaining vert keeps its position and
+///properties.
+///
+///@param r#impl The input manifold to decimate.
+///@param target_tris Stop once this many triangles remain.
+///@param max_error The largest allowed quadric error, as a distance.
+///@return MeshBoolImpl The decimated manifold.
+pub fn decimate(r#impl: &MeshBoolImpl, target_tris: usize, max_error: f64) -> MeshBoolImpl {
+    let mut result = r#impl.clone();
+    if r#impl.status != ManifoldError::NoError || r#impl.is_empty() {
+        return result;
+    }
+
+    result.decimate(target_tris, max_error);
+    result
+}
+
+///@brief Triangulates a set of &epsilon;-valid polygons. If the input is not
+///&epsilon;-valid, the triangulation may overlap, but will always return a
+///manifold result that matches the input edge directions.
+///
+///@param polygons The set of polygons, wound CCW and representing multiple
+///polygons and/or holes.
+///@param epsilon The value of &epsilon;, bounding the uncertainty of the
+///input. If negative, it is derived from the bounding box.
+///@param allow_convex If true, use a fast triangulation if the input is
+///convex.
+///@param triangulator The algorithm for non-convex input.
+///@return The triangles, referencing the polygon points in order, counting
+///across all the polygons.
+pub fn triangulate(
+    polygons: &Polygons,
+    epsilon: f64,
+    allow_convex: bool,
+    triangulator: Triangulator,
+) -> Vec<Vector3<i32>> {
+    let mut idx = 0;
+    let polygons_idx: polygon::PolygonsIdx = polygons
+        .iter()
+        .map(|poly| {
+            poly.iter()
+                .map(|&pos| {
+                    idx += 1;
+                    polygon::PolyVert { pos, idx: idx - 1 }
+                })
+                .collect()
+        })
+        .collect();
+    polygon::triangulate_idx_with(&polygons_idx, epsilon, allow_convex, triangulator)
+}
+
+///Convert a MeshGL into a Manifold, retaining its properties and merging only
+///the positions according to the merge vectors. Will return an empty Manifold
+///and set an Error Status if the result is not an oriented 2-manifold, or if a
+///faceID does not fit in an i32. Will collapse degenerate triangles and
+///unnecessary vertices.
+///
+///All fields are read, making this structure suitable for a lossless round-trip
+///of data from get_mesh_gl(). For multi-material input, use reserve_ids() to
+///set a unique originalID for each material, and sort the materials into
+///triangle runs.
+///
+///@param mesh_gl The input MeshGL or MeshGL64.
+pub fn from_mesh_gl<P: Precision, I: Index>(mesh_gl: &MeshGLP<P, I>) -> MeshBoolImpl {
+    MeshBoolImpl::from_mesh_gl(mesh_gl)
+}
+
+///Writes a finished manifold as a versioned binary snapshot, including its
+///normals, mesh relations and collider, so that read_snapshot() can restore it
+///without rebuilding any of them.
+///
+///@param r#impl The manifold to save.
+///@param writer Where to write it; buffered writers are best for files.
+pub fn write_snapshot<W: Write>(r#impl: &MeshBoolImpl, writer: &mut W) -> io::Result<()> {
+    r#impl.write_snapshot(writer)
+}
+
+///Loads a manifold saved by write_snapshot(). The arrays are decoded into
+///place, with no sorting or recomputation; only their lengths and indices are
+///checked, so the snapshot must come from a trusted source.
+///
+///Mesh IDs in the snapshot are reserved, so those of later manifolds cannot
+///collide with them.
+///
+///@param reader Positioned at the snapshot, of which exactly all bytes are read.
+///@return The manifold, or an InvalidData error if the snapshot is corrupt or
+///from an unsupported version.
+pub fn read_snapshot<R: Read>(reader: &mut R) -> io::Result<MeshBoolImpl> {
+    MeshBoolImpl::read_snapshot(reader)
+}
+
+///Reads a binary or ASCII STL file, telling them apart by content. Corners at
+///exactly the same position become one vert, and any edges left open are
+///then welded within tolerance as by MeshGL::merge(). If the result is still
+///not manifold, its status is set to NotManifold.
+///
+///@param reader The STL data, which is read in a single pass.
+///@return The manifold, or an error if reading fails or the data is malformed.
+pub fn read_stl<R: Read>(reader: R) -> io::Result<MeshBoolImpl> {
+    MeshBoolImpl::read_stl(reader)
+}
+
+///Writes a binary STL file straight from the halfedges and face normals,
+///rounding to single precision.
+///
+///@param r#impl The manifold to write.
+///@param writer Where to write it; buffering is done internally.
+pub fn write_stl<W: Write>(r#impl: &MeshBoolImpl, writer: &mut W) -> io::Result<()> {
+    r#impl.write_stl(writer)
+}
+
+///Reads a Wavefront OBJ file into a manifold. Each distinct combination of
+///group ("g" or "o") and material ("usemtl") gets its own originalID from
+///reserve_ids(), and its triangles form one run. Polygons are fanned into
+///triangles that share a faceID. Texture coordinates and normals, if present,
+///become property channels, and verts that share a position are merged.
+///
+///@param reader The OBJ data, which is read in a single pass.
+///@return The manifold, along with the groups and property channels it was
+///read into. Returns an error if reading fails or the data is malformed.
+pub fn read_obj<R: Read>(reader: R) -> io::Result<(MeshBoolImpl, ObjLayout)> {
+    MeshBoolImpl::read_obj(reader)
+}
+
+///Writes a manifold as a Wavefront OBJ file, streaming it in chunks as from
+///mesh_gl_chunks(). Each run is preceded by the "g" and "usemtl" statements of
+///its originalID in layout.groups, so materials survive a Boolean between
+///read_obj() and write_obj(); runs of unknown originals are grouped by ID. A
+///run without a material after one with a material gets "usemtl (null)". The
+///channels in layout are written as texture coordinates and normals, with the
+///normals updated as for get_mesh_gl().
+///
+///@param r#impl The manifold to write.
+///@param layout The groups and property channels, e.g. as from read_obj().
+///@param writer Where to write it; buffering is done internally.
+pub fn write_obj<W: Write>(
+    r#impl: &MeshBoolImpl,
+    layout: &ObjLayout,
+    writer: &mut W,
+) -> io::Result<()> {
+    r#impl.write_obj(layout, writer)
+}
+
+///Writes a manifold as a binary glTF (GLB) file, with one triangle primitive
+///per run, each referencing the same interleaved vertex buffer of the
+///get_mesh_gl() output. Property channels are scalar attributes named
+///_PROPERTY_i, except for the normal channels, which form the NORMAL attribute.
+///The EXT_mesh_manifold extension stores the index list of the whole mesh and
+///its merge vectors, so read_glb() restores the manifold exactly.
+///
+///@param r#impl The manifold to write; it must not be empty.
+///@param normal_idx As for get_mesh_gl(); -1 if there are no normals.
+///@param writer Where to write it; buffering is done internally.
+pub fn write_glb<W: Write>(
+    r#impl: &MeshBoolImpl,
+    normal_idx: i32,
+    writer: &mut W,
+) -> io::Result<()> {
+    r#impl.write_glb(normal_idx, writer)
+}
+
+///Reads the first mesh of a binary glTF (GLB) file. Each of its triangle
+///primitives becomes a run with a new originalID from reserve_ids(), and the
+///float attributes they all share become property channels after the
+///position, in the order of the first primitive. With the EXT_mesh_manifold
+///extension its merge vectors are used as they are; otherwise verts are
+///welded as by MeshGL::merge().
+///
+///@param reader The GLB data, which is read to its end.
+///@return The manifold, or an error if reading fails or the file is malformed
+///or uses features that are not supported, such as external buffers.
+pub fn read_glb<R: Read>(reader: R) -> io::Result<MeshBoolImpl> {
+    MeshBoolImpl::read_glb(reader)
+}
+
+///Writes a manifold as a 3MF package for printing, in millimeters. Closed runs
+///that are rigid copies of an earlier closed run of the same originalID, as
+///from translating or rotating instances before a Boolean, are not repeated:
+///that run's mesh object is written once and placed again by a component
+///transform. All other runs, such as those opened up by a Boolean, are written
+///together as one more mesh object, so every mesh is closed. These form one
+///object assembled from components, which is the only build item. The zip
+///entries are stored uncompressed and streamed, so memory is bounded by the
+///vert maps rather than the output.
+///
+///@param r#impl The manifold to write.
+///@param writer Where to write it; buffering is done internally.
+pub fn write_3mf<W: Write>(r#impl: &MeshBoolImpl, writer: &mut W) -> io::Result<()> {
+    r#impl.write_3mf(writer)
+}
+
+///Returns the first of n sequential new unique mesh IDs for marking sets of
+///triangles that can be looked up after further operations. Assign to
+///MeshGL.run_original_id vector.
+pub fn reserve_ids(n: u32) -> u32 {
+    MeshBoolImpl::reserve_ids(n as usize) as u32
+}
+
 ///The most complete output of this library, returning a MeshGL that is designed
 ///to easily push into a renderer, including all interleaved vertex properties
 ///that may have been input. It also includes relations to all the input meshes
@@ -516,179 +812,449 @@ pub fn smooth(r#impl: &MeshBoolImpl, tolerance: f64) -> MeshBoolImpl {
 ///numProp, and all original MeshGLs must use the same channels for their
 ///normals.
 pub fn get_mesh_gl(r#impl: &MeshBoolImpl, normal_idx: i32) -> MeshGL {
-    let num_prop = r#impl.num_prop();
-    let num_vert = r#impl.num_prop_vert();
-    let num_tri = r#impl.num_tri();
+    get_mesh_glp(r#impl, normal_idx)
+}
 
-    let is_original = r#impl.mesh_relation.original_id >= 0;
-    let update_normals = !is_original && normal_idx >= 0;
+///As get_mesh_gl(), but in the full double precision used internally, so that
+///positions and properties round-trip exactly through from_mesh_gl().
+pub fn get_mesh_gl64(r#impl: &MeshBoolImpl, normal_idx: i32) -> MeshGL64 {
+    get_mesh_glp(r#impl, normal_idx)
+}
 
-    let out_num_prop: u32 = 3 + num_prop as u32;
-    let tolerance = r#impl
-        .tolerance
-        .max((f32::EPSILON as f64) * r#impl.bbox.scale()) as f32;
+fn get_mesh_glp<P: Precision, I: Index>(
+    r#impl: &MeshBoolImpl,
+    normal_idx: i32,
+) -> MeshGLP<P, I> {
+    let mut mesh_gl = MeshGLP::default();
+    get_mesh_gl_into(r#impl, normal_idx, &mut mesh_gl, &mut MeshGLScratch::default());
+    mesh_gl
+}
 
-    let mut tri_verts: Vec<u32> = vec![0; 3 * num_tri];
+///Working memory for get_mesh_gl_into() and mesh_gl_chunks(). It holds no
+///results; keeping one alive between exports only lets them reuse its
+///allocations.
+#[derive(Clone, Debug, Default)]
+pub struct MeshGLScratch {
+    /// The first output triangle of each run, plus the total. Runs of
+    /// originals that contributed no triangles come last.
+    run_start: Vec<usize>,
+    run_rel: Vec<Relation>,
+    run_normal_transform: Vec<Matrix3<f64>>,
+    /// (originalID, meshID) of each run with triangles.
+    run_key: Vec<(i32, i32)>,
+    /// (meshID, run) pairs, sorted to look up the runs of a mesh.
+    run_mesh: Vec<(i32, u32)>,
+    tri_new2old: Vec<u32>,
+    /// The first output vert of each vert.
+    vert2idx: Vec<i32>,
+    /// The first output vert of each property vert, and the vert it was
+    /// output for.
+    prop2idx: Vec<i32>,
+    prop_owner: Vec<i32>,
+    /// (vert, prop, idx) for property verts shared by more than one vert.
+    shared_props: Vec<(i32, i32, u32)>,
+    num_out_vert: usize,
+}
 
-    // Sort the triangles into runs
-    let mut face_id: Vec<u32> = vec![0; num_tri];
-    let mut tri_new2old: Vec<_> = (0..num_tri).map(|i| i as i32).collect();
-    let tri_ref = &r#impl.mesh_relation.tri_ref;
-    // Don't sort originals - keep them in order
-    if !is_original {
-        tri_new2old
-            .sort_by_key(|&i| (tri_ref[i as usize].original_id, tri_ref[i as usize].mesh_id));
-    }
+impl MeshGLScratch {
+    ///Sorts the triangles into runs, finds the relation of each run, and resets
+    ///the vert maps.
+    fn begin(&mut self, r#impl: &MeshBoolImpl, update_normals: bool) {
+        let num_tri = r#impl.num_tri();
+        let is_original = r#impl.mesh_relation.original_id >= 0;
+        let tri_ref = &r#impl.mesh_relation.tri_ref;
+        let key = |tri: usize| (tri_ref[tri].original_id, tri_ref[tri].mesh_id);
+        let runs = &mut self.run_key;
+        let run_start = &mut self.run_start;
+        let tri_new2old = &mut self.tri_new2old;
 
-    let mut run_index: Vec<u32> = Vec::new();
-    let mut run_original_id: Vec<u32> = Vec::new();
-    let mut run_transform: Vec<f32> = Vec::new();
+        runs.clear();
+        run_start.clear();
+        tri_new2old.clear();
+        if is_original {
+            // Don't sort originals - keep them in order
+            for tri in 0..num_tri {
+                if tri == 0 || tri_ref[tri].mesh_id != tri_ref[tri - 1].mesh_id {
+                    runs.push(key(tri));
+                    run_start.push(tri);
+                }
+            }
+            tri_new2old.extend(0..num_tri as u32);
+        } else {
+            // A stable counting sort by (originalID, meshID). The distinct keys
+            // are few and the triangles of a mesh mostly contiguous, so they are
+            // found by collapsing repeats before sorting.
+            for tri in 0..num_tri {
+                if runs.last() != Some(&key(tri)) {
+                    runs.push(key(tri));
+                }
+            }
+            runs.sort_unstable();
+            runs.dedup();
 
-    let mut run_normal_transform: Vec<Matrix3<f64>> = Vec::new();
-    let mut add_run = |tri, rel: Relation| {
-        run_index.push((3 * tri) as u32);
-        run_original_id.push(rel.original_id as u32);
-        if update_normals {
-            run_normal_transform
-                .push(normal_transform(&rel.transform) * (if rel.back_side { -1.0 } else { 1.0 }));
-        }
+            run_start.resize(runs.len() + 1, 0);
+            let mut run = 0;
+            for tri in 0..num_tri {
+                if runs[run] != key(tri) {
+                    run = runs.binary_search(&key(tri)).unwrap();
+                }
+                run_start[run + 1] += 1;
+            }
+            for run in 1..run_start.len() {
+                run_start[run] += run_start[run - 1];
+            }
 
-        if !is_original {
-            for col in 0..4 {
-                for row in 0..3 {
-                    run_transform.push(rel.transform[(row, col)] as f32)
+            tri_new2old.resize(num_tri, 0);
+            for tri in 0..num_tri {
+                if runs[run] != key(tri) {
+                    run = runs.binary_search(&key(tri)).unwrap();
                 }
+                tri_new2old[run_start[run]] = tri as u32;
+                run_start[run] += 1;
+            }
+            // Each start has advanced to the next one.
+            run_start.rotate_right(1);
+            run_start.pop();
+            if !runs.is_empty() {
+                run_start[0] = 0;
             }
         }
-    };
 
-    let mut mesh_id_transform = r#impl.mesh_relation.mesh_id_transform.clone();
-    let mut last_id = -1;
-    for tri in 0..num_tri {
-        let old_tri = tri_new2old[tri] as usize;
-        let r#ref = tri_ref[old_tri];
-        let mesh_id = r#ref.mesh_id;
+        // Each mesh's relation goes to its first run; any later ones get the
+        // default.
+        let run_mesh = &mut self.run_mesh;
+        run_mesh.clear();
+        run_mesh.extend(runs.iter().enumerate().map(|(run, &(_, mesh_id))| (mesh_id, run as u32)));
+        run_mesh.sort_unstable();
+        let mesh_id_transform = &r#impl.mesh_relation.mesh_id_transform;
+        self.run_rel.clear();
+        for (run, &(_, mesh_id)) in runs.iter().enumerate() {
+            let first = run_mesh[run_mesh.partition_point(|&(id, _)| id < mesh_id)].1;
+            let rel = if first == run as u32 {
+                mesh_id_transform.get(&mesh_id).copied()
+            } else {
+                None
+            };
+            self.run_rel.push(rel.unwrap_or_default());
+        }
 
-        face_id[tri] = (if r#ref.face_id >= 0 {
-            r#ref.face_id
-        } else {
-            r#ref.coplanar_id
-        }) as u32;
-        for i in 0..3 {
-            tri_verts[3 * tri + i] = r#impl.halfedge[3 * old_tri + i].start_vert as u32;
+        // Add runs for originals that did not contribute any faces to the output
+        for (mesh_id, &rel) in mesh_id_transform {
+            if run_mesh.binary_search_by_key(mesh_id, |&(id, _)| id).is_err() {
+                run_start.push(num_tri);
+                self.run_rel.push(rel);
+            }
         }
+        run_start.push(num_tri);
 
-        if mesh_id != last_id {
-            let it = mesh_id_transform.remove(&mesh_id);
-            let rel = it.unwrap_or_default();
-            add_run(tri, rel);
-            last_id = mesh_id;
+        self.run_normal_transform.clear();
+        if update_normals {
+            self.run_normal_transform.extend(self.run_rel.iter().map(|rel| {
+                normal_transform(&rel.transform) * (if rel.back_side { -1.0 } else { 1.0 })
+            }));
         }
-    }
 
-    // Add runs for originals that did not contribute any faces to the output
-    for pair in mesh_id_transform {
-        add_run(num_tri, pair.1);
+        self.num_out_vert = 0;
+        self.shared_props.clear();
+        if r#impl.num_prop() > 0 {
+            self.vert2idx.clear();
+            self.vert2idx.resize(r#impl.num_vert(), -1);
+            self.prop2idx.clear();
+            self.prop2idx.resize(r#impl.num_prop_vert(), -1);
+            self.prop_owner.clear();
+            self.prop_owner.resize(r#impl.num_prop_vert(), -1);
+        }
     }
 
-    run_index.push((3 * num_tri) as u32);
+    fn num_run(&self) -> usize {
+        self.run_rel.len()
+    }
 
-    // Early return for no props
-    if num_prop == 0 {
-        let mut vert_properties: Vec<f32> = vec![0.0; 3 * num_vert];
-        for i in 0..num_vert {
-            let v = r#impl.vert_pos[i];
-            vert_properties[3 * i] = v.x as f32;
-            vert_properties[3 * i + 1] = v.y as f32;
-            vert_properties[3 * i + 2] = v.z as f32;
+    ///Appends the given runs to the run vectors of mesh_gl.
+    fn write_runs<P: Precision, I: Index>(
+        &self,
+        runs: std::ops::Range<usize>,
+        is_original: bool,
+        mesh_gl: &mut MeshGLP<P, I>,
+    ) {
+        for run in runs {
+            let rel = &self.run_rel[run];
+            mesh_gl.run_index.push(I::from_usize(3 * self.run_start[run]));
+            mesh_gl.run_original_id.push(rel.original_id as u32);
+            if !is_original {
+                for col in 0..4 {
+                    for row in 0..3 {
+                        mesh_gl.run_transform.push(P::from_f64(rel.transform[(row, col)]))
+                    }
+                }
+            }
         }
-
-        return MeshGL {
-            num_prop: out_num_prop,
-            vert_properties,
-            tri_verts,
-            merge_from_vert: Vec::default(),
-            merge_to_vert: Vec::default(),
-            run_index,
-            run_original_id,
-            run_transform,
-            face_id,
-            tolerance,
-        };
     }
 
-    // Duplicate verts with different props
-    let mut vert2idx: Vec<i32> = vec![-1; r#impl.num_vert()];
-    let mut vert_prop_pair: Vec<Vec<Vector2<i32>>> = vec![Vec::new(); r#impl.num_vert()];
-    let mut vert_properties: Vec<f32> = Vec::with_capacity(num_vert * (out_num_prop as usize));
-
-    let mut merge_from_vert: Vec<u32> = Vec::new();
-    let mut merge_to_vert: Vec<u32> = Vec::new();
+    ///Appends the given output triangles to mesh_gl, along with the verts they
+    ///are first to reference and the merges these need. Triangles must be
+    ///written in order, as vert indices count from the start of the export.
+    fn write_tris<P: Precision, I: Index>(
+        &mut self,
+        r#impl: &MeshBoolImpl,
+        tris: std::ops::Range<usize>,
+        normal_idx: i32,
+        mesh_gl: &mut MeshGLP<P, I>,
+    ) {
+        let num_prop = r#impl.num_prop();
+        let out_num_prop = 3 + num_prop;
+        let tri_ref = &r#impl.mesh_relation.tri_ref;
+        let first = mesh_gl.tri_verts.len();
+        for &old_tri in &self.tri_new2old[tris.clone()] {
+            let r#ref = tri_ref[old_tri as usize];
+            mesh_gl.face_id.push(I::from_usize(if r#ref.face_id >= 0 {
+                r#ref.face_id
+            } else {
+                r#ref.coplanar_id
+            } as usize));
+            for i in 0..3 {
+                let vert = r#impl.halfedge[3 * old_tri as usize + i].start_vert;
+                mesh_gl.tri_verts.push(I::from_usize(vert as usize));
+            }
+        }
+        if num_prop == 0 {
+            return;
+        }
 
-    for run in 0..run_original_id.len() {
-        for tri in (run_index[run] / 3)..run_index[run + 1] / 3 {
-            let tri = tri as usize;
+        // Duplicate verts with different props. Each property vert nearly
+        // always belongs to a single vert, so the pairs are found by property
+        // vert, with the rare exceptions kept aside.
+        let mut run = self.run_start.partition_point(|&start| start <= tris.start) - 1;
+        for tri in tris.clone() {
+            while self.run_start[run + 1] <= tri {
+                run += 1;
+            }
             for i in 0..3 {
-                let prop = r#impl.halfedge[3 * (tri_new2old[tri] as usize) + i].prop_vert;
-                let vert = tri_verts[3 * tri + i] as usize;
-
-                let bin = &mut vert_prop_pair[vert];
-                let mut b_found = false;
-                for b in bin.iter() {
-                    if b.x == prop {
-                        b_found = true;
-                        tri_verts[3 * tri + i] = b.y as u32;
-                        break;
-                    }
-                }
+                let halfedge = r#impl.halfedge[3 * self.tri_new2old[tri] as usize + i];
+                let prop = halfedge.prop_vert;
+                let vert = halfedge.start_vert;
+                let corner = first + 3 * (tri - tris.start) + i;
 
-                if b_found {
+                let claimed = self.prop2idx[prop as usize];
+                let found = if claimed < 0 {
+                    None
+                } else if self.prop_owner[prop as usize] == vert {
+                    Some(claimed as u32)
+                } else {
+                    self.shared_props
+                        .iter()
+                        .find(|&&(v, p, _)| v == vert && p == prop)
+                        .map(|&(_, _, idx)| idx)
+                };
+                if let Some(idx) = found {
+                    mesh_gl.tri_verts[corner] = I::from_usize(idx as usize);
                     continue;
                 }
-                let idx = vert_properties.len() / (out_num_prop as usize);
-                tri_verts[3 * tri + i] = idx as u32;
-                bin.push(Vector2::new(prop, idx as i32));
 
+                let idx = self.num_out_vert;
+                self.num_out_vert += 1;
+                mesh_gl.tri_verts[corner] = I::from_usize(idx);
+                if claimed < 0 {
+                    self.prop2idx[prop as usize] = idx as i32;
+                    self.prop_owner[prop as usize] = vert;
+                } else {
+                    self.shared_props.push((vert, prop, idx as u32));
+                }
+
+                let vert = vert as usize;
                 for p in 0..3 {
-                    vert_properties.push(r#impl.vert_pos[vert][p] as f32);
+                    mesh_gl.vert_properties.push(P::from_f64(r#impl.vert_pos[vert][p]));
                 }
                 for p in 0..num_prop {
-                    vert_properties.push(r#impl.properties[(prop as usize) * num_prop + p] as f32);
+                    let value = r#impl.properties[(prop as usize) * num_prop + p];
+                    mesh_gl.vert_properties.push(P::from_f64(value));
                 }
 
-                if update_normals {
+                if !self.run_normal_transform.is_empty() {
                     let mut normal = Vector3::<f64>::default();
-                    let start = vert_properties.len() - (out_num_prop as usize);
+                    let start =
+                        mesh_gl.vert_properties.len() - out_num_prop + 3 + normal_idx as usize;
                     for i in 0..3 {
-                        normal[i] = vert_properties[start + 3 + (normal_idx as usize) + i] as f64;
+                        normal[i] = mesh_gl.vert_properties[start + i].to_f64();
                     }
 
-                    normal = (run_normal_transform[run] * normal).normalize();
+                    // Meshes without normals have zeros here, which stay zero
+                    // rather than becoming NaN.
+                    normal = self.run_normal_transform[run] * normal;
+                    let length = normal.norm();
+                    if length > 0.0 {
+                        normal /= length;
+                    }
                     for i in 0..3 {
-                        vert_properties[start + 3 + (normal_idx as usize) + i] = normal[i] as f32;
+                        mesh_gl.vert_properties[start + i] = P::from_f64(normal[i]);
                     }
                 }
 
-                if vert2idx[vert] == -1 {
-                    vert2idx[vert] = idx as i32;
+                if self.vert2idx[vert] == -1 {
+                    self.vert2idx[vert] = idx as i32;
                 } else {
-                    merge_from_vert.push(idx as u32);
-                    merge_to_vert.push(vert2idx[vert] as u32);
+                    mesh_gl.merge_from_vert.push(I::from_usize(idx));
+                    mesh_gl.merge_to_vert.push(I::from_usize(self.vert2idx[vert] as usize));
                 }
             }
         }
     }
+}
+
+///Clears every vector of mesh_gl and sets its scalars for an export of r#impl.
+fn reset_mesh_gl<P: Precision, I: Index>(r#impl: &MeshBoolImpl, mesh_gl: &mut MeshGLP<P, I>) {
+    mesh_gl.num_prop = 3 + r#impl.num_prop() as u32;
+    mesh_gl.tolerance = P::from_f64(r#impl.tolerance.max(P::EPSILON * r#impl.bbox.scale()));
+    mesh_gl.vert_properties.clear();
+    mesh_gl.tri_verts.clear();
+    mesh_gl.merge_from_vert.clear();
+    mesh_gl.merge_to_vert.clear();
+    mesh_gl.run_index.clear();
+    mesh_gl.run_original_id.clear();
+    mesh_gl.run_transform.clear();
+    mesh_gl.face_id.clear();
+}
+
+///Appends the positions of verts [start, end) for a mesh without properties,
+///whose output verts are simply its verts.
+fn write_positions<P: Precision, I: Index>(
+    r#impl: &MeshBoolImpl,
+    verts: std::ops::Range<usize>,
+    mesh_gl: &mut MeshGLP<P, I>,
+) {
+    for v in &r#impl.vert_pos[verts] {
+        mesh_gl.vert_properties.extend(v.iter().map(|&x| P::from_f64(x)));
+    }
+}
+
+///As get_mesh_gl() or get_mesh_gl64(), but writing into an existing MeshGL,
+///whose vectors are cleared and refilled. Reusing the same MeshGL and scratch
+///for repeated exports, the result is identical but no heap allocation takes
+///place once their capacities have grown to fit.
+///
+///@param r#impl The manifold to export.
+///@param normal_idx As for get_mesh_gl().
+///@param mesh_gl The output, overwritten entirely.
+///@param scratch Working memory, reusable between calls.
+pub fn get_mesh_gl_into<P: Precision, I: Index>(
+    r#impl: &MeshBoolImpl,
+    normal_idx: i32,
+    mesh_gl: &mut MeshGLP<P, I>,
+    scratch: &mut MeshGLScratch,
+) {
+    let is_original = r#impl.mesh_relation.original_id >= 0;
+    scratch.begin(r#impl, !is_original && normal_idx >= 0);
+    reset_mesh_gl(r#impl, mesh_gl);
+    scratch.write_runs(0..scratch.num_run(), is_original, mesh_gl);
+    mesh_gl.run_index.push(I::from_usize(3 * r#impl.num_tri()));
+    scratch.write_tris(r#impl, 0..r#impl.num_tri(), normal_idx, mesh_gl);
+    if r#impl.num_prop() == 0 {
+        write_positions(r#impl, 0..r#impl.num_prop_vert(), mesh_gl);
+    }
+}
+
+///Exports a manifold piece by piece, for consumers that write the mesh out
+///(e.g. to disk or a socket) without holding all of it in memory. Each chunk
+///is a MeshGL holding the next part of every vector of the get_mesh_gl()
+///output, such that appending them all in order reproduces it exactly. Beyond
+///the manifold itself only a few integers per triangle and per vert are kept
+///between chunks.
+///
+///All indices refer to the complete mesh, e.g. the triangles of a chunk can
+///refer to verts of earlier chunks, but never to those of later ones, and
+///runIndex values count from the first triangle. A run's entry comes in the
+///chunk holding its first triangle, and the final runIndex entry, along with
+///the runs of originals that contributed no triangles, in the last chunk. For a
+///manifold with properties, a vert comes in the chunk of the first triangle to
+///use it. Without properties, verts keep their internal order, and each chunk
+///continues them up to the last vert its triangles use.
+///
+///@param r#impl The manifold to export.
+///@param normal_idx As for get_mesh_gl().
+///@param max_tris The most triangles per chunk. With properties, a chunk then
+///holds at most three times as many verts.
+pub fn mesh_gl_chunks<P: Precision, I: Index>(
+    r#impl: &MeshBoolImpl,
+    normal_idx: i32,
+    max_tris: usize,
+) -> MeshGLChunks<'_, P, I> {
+    let is_original = r#impl.mesh_relation.original_id >= 0;
+    let mut scratch = MeshGLScratch::default();
+    scratch.begin(r#impl, !is_original && normal_idx >= 0);
+    let max_tris = max_tris.max(1);
+    let num_chunk = r#impl.num_tri().div_ceil(max_tris).max(1);
+    MeshGLChunks {
+        r#impl,
+        normal_idx,
+        max_tris,
+        scratch,
+        chunk: 0,
+        num_chunk,
+        next_run: 0,
+        next_vert: 0,
+        _precision: std::marker::PhantomData,
+    }
+}
+
+///The iterator returned by mesh_gl_chunks().
+pub struct MeshGLChunks<'a, P, I> {
+    r#impl: &'a MeshBoolImpl,
+    normal_idx: i32,
+    max_tris: usize,
+    scratch: MeshGLScratch,
+    chunk: usize,
+    num_chunk: usize,
+    next_run: usize,
+    next_vert: usize,
+    _precision: std::marker::PhantomData<(P, I)>,
+}
+
+impl<'a, P: Precision, I: Index> MeshGLChunks<'a, P, I> {
+    ///Writes the next chunk into mesh_gl, overwriting it, so a single buffer can
+    ///be reused for the whole export. Returns false once all chunks are done.
+    pub fn next_into(&mut self, mesh_gl: &mut MeshGLP<P, I>) -> bool {
+        if self.chunk == self.num_chunk {
+            return false;
+        }
+        let r#impl = self.r#impl;
+        let num_tri = r#impl.num_tri();
+        let is_last = self.chunk + 1 == self.num_chunk;
+        let tris = self.chunk * self.max_tris..num_tri.min((self.chunk + 1) * self.max_tris);
+
+        reset_mesh_gl(r#impl, mesh_gl);
+        let end_run = if is_last {
+            self.scratch.num_run()
+        } else {
+            self.scratch.run_start.partition_point(|&start| start < tris.end)
+        };
+        let is_original = r#impl.mesh_relation.original_id >= 0;
+        self.scratch.write_runs(self.next_run..end_run, is_original, mesh_gl);
+        self.next_run = end_run;
+        if is_last {
+            mesh_gl.run_index.push(I::from_usize(3 * num_tri));
+        }
+
+        self.scratch.write_tris(r#impl, tris, self.normal_idx, mesh_gl);
+        if r#impl.num_prop() == 0 {
+            let end = if is_last {
+                r#impl.num_prop_vert()
+            } else {
+                let used = mesh_gl.tri_verts.iter().map(|v| v.to_usize() + 1).max();
+                used.unwrap_or(0).max(self.next_vert)
+            };
+            write_positions(r#impl, self.next_vert..end, mesh_gl);
+            self.next_vert = end;
+        }
+        self.chunk += 1;
+        true
+    }
+}
+
+impl<'a, P: Precision, I: Index> Iterator for MeshGLChunks<'a, P, I> {
+    type Item = MeshGLP<P, I>;
 
-    MeshGL {
-        num_prop: out_num_prop,
-        vert_properties,
-        tri_verts,
-        merge_from_vert,
-        merge_to_vert,
-        run_index,
-        run_original_id,
-        run_transform,
-        face_id,
-        tolerance,
+    fn next(&mut self) -> Option<Self::Item> {
+        let mut mesh_gl = MeshGLP::default();
+        self.next_into(&mut mesh_gl).then_some(mesh_gl)
     }
 }
@@ -0,0 +1,180 @@
+use crate::{Index, MeshGLP, Precision};
+use crate::collider::{Collider, Recorder};
+use crate::common::Aabb;
+use crate::disjoint_sets::DisjointSets;
+use nalgebra::{Point3, Vector3};
+
+///Unites every pair of open verts whose tolerance boxes overlap.
+struct MergeRecorder<'a> {
+    open_verts: &'a [u32],
+    merges: &'a DisjointSets,
+}
+
+impl<'a> Recorder for MergeRecorder<'a> {
+    fn record(&mut self, query_idx: i32, leaf_idx: i32) {
+        self.merges.unite(
+            self.open_verts[query_idx as usize],
+            self.open_verts[leaf_idx as usize],
+        );
+    }
+}
+
+///Flags both verts of every edge that is not matched by an opposed edge, after
+///applying the existing merges. Each halfedge is keyed by its sorted vert pair
+///and a direction bit, so after sorting, all copies of an edge are adjacent with
+///the backward ones first, and a closed edge has as many of one as of the
+///other. Vert indices fit in 31 bits, so the key fits in a u64.
+fn open_verts<P, I: Index>(
+    mesh_gl: &MeshGLP<P, I>,
+    merges: &DisjointSets,
+    num_vert: usize,
+) -> Vec<u32> {
+    let mut edges: Vec<u64> = Vec::with_capacity(mesh_gl.tri_verts.len());
+    for tri in mesh_gl.tri_verts.chunks_exact(3) {
+        for i in 0..3 {
+            let v0 = merges.find(tri[i].to_usize() as u32);
+            let v1 = merges.find(tri[(i + 1) % 3].to_usize() as u32);
+            let key = (v0.min(v1) as u64) << 32 | (v0.max(v1) as u64) << 1;
+            edges.push(key | (v0 < v1) as u64);
+        }
+    }
+    edges.sort_unstable();
+
+    let mut is_open = vec![false; num_vert];
+    let mut start = 0;
+    while start < edges.len() {
+        let key = edges[start] >> 1;
+        let end = start + edges[start..].partition_point(|&edge| edge >> 1 == key);
+        let num_backward = edges[start..end].partition_point(|&edge| edge & 1 == 0);
+        if 2 * num_backward != end - start {
+            is_open[(key >> 31) as usize] = true;
+            is_open[(key & 0x7FFFFFFF) as usize] = true;
+        }
+        start = end;
+    }
+
+    (0..num_vert as u32)
+        .filter(|&vert| is_open[vert as usize])
+        .collect()
+}
+
+impl<P: Precision, I: Index> MeshGLP<P, I> {
+    ///Updates the mergeFromVert and mergeToVert vectors in order to create a
+    ///manifold solid. If the MeshGL is already manifold, no change will occur and
+    ///the function will return false. Otherwise, this will merge verts along open
+    ///edges within tolerance (the maximum of the MeshGL tolerance and the
+    ///baseline bounding-box tolerance), keeping any from the existing merge
+    ///vectors, and return true.
+    ///
+    ///There is no guarantee the result will be manifold - this is a best-effort
+    ///helper function designed primarily to aid in the case where a manifold
+    ///multi-material MeshGL was produced, but its merge vectors were lost due to
+    ///a round-trip through a file format. Constructing a Manifold from the result
+    ///will report an error status if it is not manifold.
+    pub fn merge(&mut self) -> bool {
+        let num_prop = self.num_prop as usize;
+        if num_prop < 3 || self.merge_from_vert.len() != self.merge_to_vert.len() {
+            return false;
+        }
+        let num_vert = self.vert_properties.len() / num_prop;
+        let in_bounds = |vert: &I| vert.to_usize() < num_vert;
+        if num_vert > i32::MAX as usize
+            || !self.tri_verts.iter().all(in_bounds)
+            || !self.merge_from_vert.iter().all(in_bounds)
+            || !self.merge_to_vert.iter().all(in_bounds)
+        {
+            return false;
+        }
+
+        let merges = DisjointSets::new(num_vert as u32);
+        for (&from, &to) in self.merge_from_vert.iter().zip(&self.merge_to_vert) {
+            merges.unite(from.to_usize() as u32, to.to_usize() as u32);
+        }
+
+        let mut open_verts = open_verts(self, &merges, num_vert);
+        if open_verts.is_empty() {
+            return false;
+        }
+
+        let pos = |vert: u32| {
+            let i = vert as usize * num_prop;
+            Point3::new(
+                self.vert_properties[i].to_f64(),
+                self.vert_properties[i + 1].to_f64(),
+                self.vert_properties[i + 2].to_f64(),
+            )
+        };
+        let mut bbox = Aabb::default();
+        for vert in 0..num_vert as u32 {
+            bbox.union_point(pos(vert));
+        }
+        let tolerance = self.tolerance.to_f64().max(P::EPSILON * bbox.scale());
+
+        // Sort the open verts along the Morton curve, so that the collider's radix
+        // tree groups nearby verts and each query only visits its neighborhood.
+        // Within a Morton cell, sorting by position puts exact duplicates next to
+        // each other, as is typical of triangle soups. These are welded directly
+        // and only the first of each enters the collider.
+        let mut vert_morton: Vec<(u32, Point3<f64>, u32)> = open_verts
+            .iter()
+            .map(|&vert| {
+                let p = pos(vert);
+                (Collider::morton_code(p, bbox), p, vert)
+            })
+            .collect();
+        vert_morton.sort_unstable_by(|a, b| {
+            a.0.cmp(&b.0)
+                .then(a.1.x.total_cmp(&b.1.x))
+                .then(a.1.y.total_cmp(&b.1.y))
+                .then(a.1.z.total_cmp(&b.1.z))
+        });
+        open_verts.clear();
+        let mut leaf_morton = Vec::new();
+        for (i, &(code, p, vert)) in vert_morton.iter().enumerate() {
+            if i > 0 && vert_morton[i - 1].1 == p {
+                merges.unite(*open_verts.last().unwrap(), vert);
+            } else {
+                open_verts.push(vert);
+                leaf_morton.push(code);
+            }
+        }
+        drop(vert_morton);
+
+        let half = Vector3::from_element(tolerance / 2.0);
+        let vert_box: Vec<Aabb> = open_verts
+            .iter()
+            .map(|&vert| {
+                let center = pos(vert);
+                Aabb {
+                    min: center - half,
+                    max: center + half,
+                }
+            })
+            .collect();
+
+        // A lone open vert has nothing to weld to.
+        if open_verts.len() > 1 {
+            let collider = Collider::new(&vert_box, &leaf_morton);
+            let mut recorder = MergeRecorder {
+                open_verts: &open_verts,
+                merges: &merges,
+            };
+            collider.collisions::<_, _, MergeRecorder>(
+                |i| vert_box[i as usize],
+                vert_box.len(),
+                &mut recorder,
+            );
+        }
+
+        self.merge_from_vert.clear();
+        self.merge_to_vert.clear();
+        for vert in 0..num_vert as u32 {
+            let merge_to = merges.find(vert);
+            if merge_to != vert {
+                self.merge_from_vert.push(I::from_usize(vert as usize));
+                self.merge_to_vert.push(I::from_usize(merge_to as usize));
+            }
+        }
+        true
+    }
+}
@@ -1,6 +1,7 @@
-use crate::ManifoldError;
+use crate::{Index, ManifoldError, MeshGLP, Precision};
 use crate::collider::Collider;
 use crate::common::{Aabb, sun_acos};
+use crate::disjoint_sets::DisjointSets;
 use crate::mesh_fixes::{FlipTris, transform_normal};
 use crate::parallel::exclusive_scan_in_place;
 use crate::shared::{Halfedge, TriRef, max_epsilon, next_halfedge, normal_transform};
@@ -70,6 +71,39 @@ pub(crate) struct MeshRelationD {
     pub tri_ref: Vec<TriRef>,
 }
 
+///Heap bytes held by each component of a MeshBoolImpl, as reported by
+///memory_footprint(). Vectors are counted by capacity, since that is what is
+///actually allocated.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct MemoryFootprint {
+    pub vert_pos: usize,
+    pub halfedge: usize,
+    pub properties: usize,
+    pub vert_normal: usize,
+    pub face_normal: usize,
+    pub tri_ref: usize,
+    /// Estimated from the entry count, as the map's node overhead is not exposed.
+    pub mesh_id_transform: usize,
+    pub collider: usize,
+}
+
+impl MemoryFootprint {
+    pub fn total(&self) -> usize {
+        self.vert_pos
+            + self.halfedge
+            + self.properties
+            + self.vert_normal
+            + self.face_normal
+            + self.tri_ref
+            + self.mesh_id_transform
+            + self.collider
+    }
+}
+
+fn vec_bytes<T>(v: &Vec<T>) -> usize {
+    v.capacity() * mem::size_of::<T>()
+}
+
 impl Default for MeshRelationD {
     fn default() -> Self {
         MeshRelationD {
@@ -125,6 +159,21 @@ impl MeshBoolImpl {
             self.properties.len() / self.num_prop()
         }
     }
+
+    ///Returns the heap bytes held by each of this mesh's arrays.
+    pub fn memory_footprint(&self) -> MemoryFootprint {
+        MemoryFootprint {
+            vert_pos: vec_bytes(&self.vert_pos),
+            halfedge: vec_bytes(&self.halfedge),
+            properties: vec_bytes(&self.properties),
+            vert_normal: vec_bytes(&self.vert_normal),
+            face_normal: vec_bytes(&self.face_normal),
+            tri_ref: vec_bytes(&self.mesh_relation.tri_ref),
+            mesh_id_transform: self.mesh_relation.mesh_id_transform.len()
+                * (mem::size_of::<i32>() + mem::size_of::<Relation>()),
+            collider: self.collider.memory_footprint(),
+        }
+    }
 }
 
 const K_REMOVED_HALFEDGE: i32 = -2;
@@ -136,6 +185,106 @@ struct HalfedgePairData {
     edge_index: i32,
 }
 
+struct TriPriority {
+    area2: f64,
+    tri: i32,
+}
+
+///Distance of vert from the plane of tri, as measured in mark_coplanar.
+fn plane_dist(
+    halfedge: &[Halfedge],
+    vert_pos: &[Point3<f64>],
+    face_normal: &[Vector3<f64>],
+    tri: usize,
+    vert: i32,
+) -> f64 {
+    let base = vert_pos[halfedge[3 * tri].start_vert as usize];
+    (vert_pos[vert as usize] - base)
+        .dot(&face_normal[tri])
+        .abs()
+}
+
+struct CoplanarEdge<'a> {
+    halfedge: &'a [Halfedge],
+    vert_pos: &'a [Point3<f64>],
+    face_normal: &'a [Vector3<f64>],
+    tolerance: f64,
+    coplanar_sets: &'a DisjointSets,
+}
+
+impl<'a> CoplanarEdge<'a> {
+    fn call(&self, edge: usize) {
+        let h = self.halfedge[edge];
+        if !h.is_forward() || h.start_vert < 0 || h.paired_halfedge < 0 {
+            return;
+        }
+
+        let pair = h.paired_halfedge as usize;
+        let (tri, neighbor) = (edge / 3, pair / 3);
+        if self.halfedge[3 * neighbor].start_vert < 0 {
+            return;
+        }
+
+        let far_tri = self.halfedge[next_halfedge(edge as i32) as usize].end_vert;
+        let far_neighbor = self.halfedge[next_halfedge(pair as i32) as usize].end_vert;
+        if plane_dist(
+            self.halfedge,
+            self.vert_pos,
+            self.face_normal,
+            tri,
+            far_neighbor,
+        ) < self.tolerance
+            && plane_dist(
+                self.halfedge,
+                self.vert_pos,
+                self.face_normal,
+                neighbor,
+                far_tri,
+            ) < self.tolerance
+        {
+            self.coplanar_sets.unite(tri as u32, neighbor as u32);
+        }
+    }
+}
+
+struct VerifySeed<'a> {
+    halfedge: &'a [Halfedge],
+    vert_pos: &'a [Point3<f64>],
+    face_normal: &'a [Vector3<f64>],
+    tolerance: f64,
+    coplanar_sets: &'a DisjointSets,
+    seed: &'a [i32],
+    flat: &'a [AtomicI32],
+}
+
+impl<'a> VerifySeed<'a> {
+    fn call(&self, edge: usize) {
+        let h = self.halfedge[edge];
+        if h.start_vert < 0 {
+            return;
+        }
+
+        let root = self.coplanar_sets.find((edge / 3) as u32) as usize;
+        let seed = self.seed[root] as usize;
+        let on_plane = |vert: i32| {
+            plane_dist(self.halfedge, self.vert_pos, self.face_normal, seed, vert) < self.tolerance
+        };
+
+        let mut ok = on_plane(h.end_vert);
+        if ok && h.paired_halfedge >= 0 {
+            let pair = h.paired_halfedge;
+            let neighbor = (pair / 3) as u32;
+            if self.coplanar_sets.find(neighbor) as usize != root {
+                ok = !on_plane(self.halfedge[next_halfedge(pair) as usize].end_vert);
+            }
+        }
+
+        if !ok {
+            self.flat[root].store(0, AtomicOrdering::Relaxed);
+        }
+    }
+}
+
 struct PrepHalfedges<'a, const USE_PROP: bool, F: FnMut(i32, i32, i32)> {
     halfedges: &'a mut Vec<Halfedge>,
     tri_prop: &'a Vec<Vector3<i32>>,
@@ -254,6 +403,207 @@ impl MeshBoolImpl {
         r#impl
     }
 
+    ///Builds a manifold from a MeshGL. The merge vectors are applied as unions in
+    ///a DisjointSets, so chains of merges collapse to a single vert, and with
+    ///properties the triangles keep pointing at their propVerts through
+    ///prop2vert. The runs restore each triangle's TriRef and the meshID
+    ///transforms.
+    pub(crate) fn from_mesh_gl<P: Precision, I: Index>(mesh_gl: &MeshGLP<P, I>) -> Self {
+        let mut r#impl = Self::default();
+        let num_prop_in = mesh_gl.num_prop as usize;
+        if num_prop_in < 3 {
+            r#impl.make_empty(ManifoldError::MissingPositionProperties);
+            return r#impl;
+        }
+        let num_vert = mesh_gl.vert_properties.len() / num_prop_in;
+        let num_tri = mesh_gl.tri_verts.len() / 3;
+        if num_vert == 0 && num_tri == 0 {
+            return r#impl;
+        }
+        if num_vert > i32::MAX as usize || num_tri > i32::MAX as usize / 3 {
+            r#impl.make_empty(ManifoldError::ResultTooLarge);
+            return r#impl;
+        }
+        if num_vert < 4 || num_tri < 4 {
+            r#impl.make_empty(ManifoldError::NotManifold);
+            return r#impl;
+        }
+        if mesh_gl.merge_from_vert.len() != mesh_gl.merge_to_vert.len() {
+            r#impl.make_empty(ManifoldError::MergeVectorsDifferentLengths);
+            return r#impl;
+        }
+        if !mesh_gl.run_transform.is_empty()
+            && 12 * mesh_gl.run_original_id.len() != mesh_gl.run_transform.len()
+        {
+            r#impl.make_empty(ManifoldError::TransformWrongLength);
+            return r#impl;
+        }
+        if !mesh_gl.run_original_id.is_empty()
+            && !mesh_gl.run_index.is_empty()
+            && mesh_gl.run_original_id.len() + 1 != mesh_gl.run_index.len()
+            && mesh_gl.run_original_id.len() != mesh_gl.run_index.len()
+        {
+            r#impl.make_empty(ManifoldError::RunIndexWrongLength);
+            return r#impl;
+        }
+        if !mesh_gl.face_id.is_empty() && mesh_gl.face_id.len() != num_tri {
+            r#impl.make_empty(ManifoldError::FaceIdWrongLength);
+            return r#impl;
+        }
+        if mesh_gl.face_id.iter().any(|id| id.to_usize() > i32::MAX as usize) {
+            r#impl.make_empty(ManifoldError::InvalidConstruction);
+            return r#impl;
+        }
+        if !mesh_gl.vert_properties.iter().all(|x| x.to_f64().is_finite()) {
+            r#impl.make_empty(ManifoldError::NonFiniteVertex);
+            return r#impl;
+        }
+        if !mesh_gl.run_transform.iter().all(|x| x.to_f64().is_finite()) {
+            r#impl.make_empty(ManifoldError::InvalidConstruction);
+            return r#impl;
+        }
+
+        let merges = DisjointSets::new(num_vert as u32);
+        for (&from, &to) in mesh_gl.merge_from_vert.iter().zip(&mesh_gl.merge_to_vert) {
+            if from.to_usize() >= num_vert || to.to_usize() >= num_vert {
+                r#impl.make_empty(ManifoldError::MergeIndexOutOfBounds);
+                return r#impl;
+            }
+            merges.unite(from.to_usize() as u32, to.to_usize() as u32);
+        }
+        let prop2vert: Vec<i32> = (0..num_vert as u32)
+            .map(|vert| merges.find(vert) as i32)
+            .collect();
+
+        let num_prop = num_prop_in - 3;
+        r#impl.num_prop = num_prop as i32;
+        r#impl.tolerance = mesh_gl.tolerance.to_f64();
+        // This will have unreferenced duplicate positions that will be removed by
+        // remove_unreferenced_verts() and finish().
+        r#impl.vert_pos.reserve_exact(num_vert);
+        r#impl.properties.reserve_exact(num_vert * num_prop);
+        for vert in mesh_gl.vert_properties.chunks_exact(num_prop_in) {
+            r#impl.vert_pos.push(Point3::new(
+                vert[0].to_f64(),
+                vert[1].to_f64(),
+                vert[2].to_f64(),
+            ));
+            r#impl
+                .properties
+                .extend(vert[3..].iter().map(|&p| p.to_f64()));
+        }
+
+        let mut run_index: Vec<usize> =
+            mesh_gl.run_index.iter().map(|i| i.to_usize()).collect();
+        let run_end = mesh_gl.tri_verts.len();
+        if run_index.is_empty() {
+            run_index = vec![0, run_end];
+        } else if run_index.len() == mesh_gl.run_original_id.len() || run_index.len() == 1 {
+            run_index.push(run_end);
+        }
+        let num_run = mesh_gl.run_original_id.len().max(1);
+        if run_index.len() != num_run + 1
+            || run_index[0] != 0
+            || run_index[num_run] != run_end
+            || run_index.windows(2).any(|run| run[0] > run[1])
+        {
+            r#impl.make_empty(ManifoldError::RunIndexWrongLength);
+            return r#impl;
+        }
+
+        let start_id = MeshBoolImpl::reserve_ids(num_run) as i32;
+        // The runs cover every triangle, so each of these is overwritten.
+        let mut tri_ref = vec![
+            TriRef {
+                mesh_id: start_id,
+                original_id: -1,
+                face_id: -1,
+                coplanar_id: -1,
+            };
+            num_tri
+        ];
+        for run in 0..num_run {
+            let mesh_id = start_id + run as i32;
+            let original_id = mesh_gl
+                .run_original_id
+                .get(run)
+                .map_or(start_id, |&id| id as i32);
+            for tri in run_index[run] / 3..run_index[run + 1] / 3 {
+                tri_ref[tri] = TriRef {
+                    mesh_id,
+                    original_id,
+                    face_id: mesh_gl.face_id.get(tri).map_or(-1, |&id| id.to_usize() as i32),
+                    coplanar_id: tri as i32,
+                };
+            }
+
+            let transform = if mesh_gl.run_transform.is_empty() {
+                Matrix3x4::identity()
+            } else {
+                Matrix3x4::from_fn(|row, col| {
+                    mesh_gl.run_transform[12 * run + 3 * col + row].to_f64()
+                })
+            };
+            r#impl.mesh_relation.mesh_id_transform.insert(
+                mesh_id,
+                Relation {
+                    original_id,
+                    transform,
+                    back_side: false,
+                },
+            );
+        }
+
+        // Triangles that were merged down to an edge are dropped here, and any
+        // other degenerates are collapsed by simplify_topology() below.
+        let needs_prop_map = num_prop > 0;
+        let mut tri_prop = Vec::with_capacity(num_tri);
+        let mut tri_vert = Vec::with_capacity(if needs_prop_map { num_tri } else { 0 });
+        r#impl.mesh_relation.tri_ref.reserve_exact(num_tri);
+        for (tri, verts) in mesh_gl.tri_verts.chunks_exact(3).enumerate() {
+            if verts.iter().any(|&vert| vert.to_usize() >= num_vert) {
+                r#impl.make_empty(ManifoldError::VertexOutOfBounds);
+                return r#impl;
+            }
+            let tri_p = Vector3::from_fn(|i, _| verts[i].to_usize() as i32);
+            let tri_v = tri_p.map(|vert| prop2vert[vert as usize]);
+            if tri_v[0] == tri_v[1] || tri_v[1] == tri_v[2] || tri_v[2] == tri_v[0] {
+                continue;
+            }
+            if needs_prop_map {
+                tri_prop.push(tri_p);
+                tri_vert.push(tri_v);
+            } else {
+                tri_prop.push(tri_v);
+            }
+            r#impl.mesh_relation.tri_ref.push(tri_ref[tri]);
+        }
+
+        r#impl.create_halfedges(tri_prop, tri_vert);
+        if !r#impl.is_manifold() {
+            r#impl.make_empty(ManifoldError::NotManifold);
+            return r#impl;
+        }
+
+        r#impl.calculate_bbox();
+        // The input cannot be trusted beyond its own precision.
+        r#impl.set_epsilon(-1.0, false);
+        r#impl.tolerance = r#impl.tolerance.max(P::EPSILON * r#impl.bbox.scale());
+        r#impl.cleanup_topology();
+        // Collapsing checks same_face(), so the faces must be known first.
+        r#impl.calculate_normals();
+        r#impl.mark_coplanar();
+        r#impl.simplify_topology(0);
+        r#impl.remove_unreferenced_verts();
+        r#impl.finish();
+        r#impl.mark_coplanar();
+
+        // A manifold created from an input mesh is never an original - the input
+        // is the original.
+        r#impl.mesh_relation.original_id = -1;
+        r#impl
+    }
+
     pub(crate) fn remove_unreferenced_verts(&mut self) {
         let num_vert = self.num_vert();
         let keep = vec![0; num_vert];
@@ -272,7 +622,7 @@ impl MeshBoolImpl {
         }
     }
 
-    fn reserve_ids(n: usize) -> usize {
+    pub(crate) fn reserve_ids(n: usize) -> usize {
         MESH_ID_COUNTER.fetch_add(n, AtomicOrdering::Relaxed)
     }
 
@@ -307,12 +657,16 @@ impl MeshBoolImpl {
         }
     }
 
+    ///Assigns each triangle the coplanar_id of the largest triangle of the planar
+    ///region it belongs to. Coplanarity is first tested independently per edge,
+    ///uniting the two triangles whenever each one's far vertex lies on the
+    ///other's plane. Each resulting set is seeded by its largest triangle (ties
+    ///to the lower index) and verified to match what a flood fill from that seed
+    ///would claim: every vertex on the seed's plane and no neighbor across the
+    ///set boundary that the fill would leak into. If any set fails, e.g. on
+    ///gently curved surfaces, the exact sequential flood fill is used instead.
     pub(crate) fn mark_coplanar(&mut self) {
         let num_tri = self.num_tri();
-        struct TriPriority {
-            area2: f64,
-            tri: i32,
-        }
         let mut tri_priority = unsafe { vec_uninit(num_tri) };
         for tri in 0..num_tri {
             self.mesh_relation.tri_ref[tri].coplanar_id = -1;
@@ -335,12 +689,62 @@ impl MeshBoolImpl {
 
         tri_priority.sort_by(|a, b| b.area2.partial_cmp(&a.area2).unwrap_or(CmpOrdering::Equal));
 
-        let mut interior_halfedges: Vec<i32> = Vec::default();
+        let coplanar_sets = DisjointSets::new(num_tri as u32);
+        let unite_coplanar = CoplanarEdge {
+            halfedge: &self.halfedge,
+            vert_pos: &self.vert_pos,
+            face_normal: &self.face_normal,
+            tolerance: self.tolerance,
+            coplanar_sets: &coplanar_sets,
+        };
+        for edge in 0..self.halfedge.len() {
+            unite_coplanar.call(edge);
+        }
+
+        //tri_priority is stably sorted, so the first member of each set visited
+        //is its largest triangle, ties going to the lower index.
+        let mut seed = vec![-1; num_tri];
         for tp in &tri_priority {
+            let root = coplanar_sets.find(tp.tri as u32) as usize;
+            if seed[root] < 0 {
+                seed[root] = tp.tri;
+            }
+        }
+
+        let flat: Vec<AtomicI32> = (0..num_tri).map(|_| AtomicI32::new(1)).collect();
+        let verify_seed = VerifySeed {
+            halfedge: &self.halfedge,
+            vert_pos: &self.vert_pos,
+            face_normal: &self.face_normal,
+            tolerance: self.tolerance,
+            coplanar_sets: &coplanar_sets,
+            seed: &seed,
+            flat: &flat,
+        };
+        for edge in 0..self.halfedge.len() {
+            verify_seed.call(edge);
+        }
+
+        if flat.iter().any(|f| f.load(AtomicOrdering::Relaxed) == 0) {
+            self.flood_coplanar(&tri_priority);
+            return;
+        }
+
+        for tri in 0..num_tri {
+            self.mesh_relation.tri_ref[tri].coplanar_id =
+                seed[coplanar_sets.find(tri as u32) as usize];
+        }
+    }
+
+    ///Sequentially flood-fills coplanar regions from each unassigned seed in
+    ///order of decreasing area. Any neighbor whose far vertex lies within
+    ///tolerance of the seed's plane joins the seed's region.
+    fn flood_coplanar(&mut self, tri_priority: &[TriPriority]) {
+        let mut interior_halfedges: Vec<i32> = Vec::default();
+        for tp in tri_priority {
             if self.mesh_relation.tri_ref[tp.tri as usize].coplanar_id >= 0 {
                 continue;
             }
-
             self.mesh_relation.tri_ref[tp.tri as usize].coplanar_id = tp.tri;
             if self.halfedge[(3 * tp.tri) as usize].start_vert < 0 {
                 continue;
@@ -510,7 +914,7 @@ impl MeshBoolImpl {
                         ids[i as usize] = i;
                     }
 
-                    ids.sort_unstable_by_key(|&i| {
+                    ids[start as usize..end as usize].sort_unstable_by_key(|&i| {
                         let entry = &entries[i as usize];
                         (entry.large_vert, entry.tri)
                     });
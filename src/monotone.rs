@@ -0,0 +1,731 @@
+use crate::common::Rect;
+use crate::polygon::PolygonsIdx;
+use crate::utils::{K_PRECISION, ccw};
+use nalgebra::{Point2, Vector3};
+use std::cmp::Ordering;
+
+const K_NONE: usize = usize::MAX;
+
+///The sweep runs from top to bottom: decreasing y, then increasing x. This is a
+///total order on distinct points, equivalent to a sweep line rotated by an
+///infinitesimal angle, so horizontal edges need no special cases.
+fn sweep_cmp(a: Point2<f64>, b: Point2<f64>) -> Ordering {
+    b.y.total_cmp(&a.y).then(a.x.total_cmp(&b.x))
+}
+
+fn above(a: Point2<f64>, b: Point2<f64>) -> bool {
+    sweep_cmp(a, b) == Ordering::Less
+}
+
+fn orient(a: Point2<f64>, b: Point2<f64>, c: Point2<f64>) -> f64 {
+    (b - a).perp(&(c - a))
+}
+
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum VertType {
+    Start,
+    End,
+    Split,
+    Merge,
+    Regular,
+}
+
+///The edges crossing the sweep line that have the polygon's interior on their
+///right, ordered left to right. This is a treap over edge indices, since the
+///order is only defined by comparisons at the current sweep position; parent
+///links allow removing an edge by index in O(log n).
+struct SweepStatus {
+    root: usize,
+    left: Vec<usize>,
+    right: Vec<usize>,
+    parent: Vec<usize>,
+    in_tree: Vec<bool>,
+}
+
+impl SweepStatus {
+    fn new(num_edge: usize) -> Self {
+        Self {
+            root: K_NONE,
+            left: vec![K_NONE; num_edge],
+            right: vec![K_NONE; num_edge],
+            parent: vec![K_NONE; num_edge],
+            in_tree: vec![false; num_edge],
+        }
+    }
+
+    ///A fixed pseudo-random heap priority per edge, so the result is
+    ///deterministic.
+    fn priority(edge: usize) -> u64 {
+        let mut x = (edge as u64).wrapping_add(0x9e3779b97f4a7c15);
+        x = (x ^ (x >> 30)).wrapping_mul(0xbf58476d1ce4e5b9);
+        x = (x ^ (x >> 27)).wrapping_mul(0x94d049bb133111eb);
+        x ^ (x >> 31)
+    }
+
+    fn replace_child(&mut self, parent: usize, old: usize, new: usize) {
+        if parent == K_NONE {
+            self.root = new;
+        } else if self.left[parent] == old {
+            self.left[parent] = new;
+        } else {
+            self.right[parent] = new;
+        }
+    }
+
+    fn rotate_up(&mut self, x: usize) {
+        let p = self.parent[x];
+        let g = self.parent[p];
+        if self.left[p] == x {
+            let b = self.right[x];
+            self.left[p] = b;
+            if b != K_NONE {
+                self.parent[b] = p;
+            }
+            self.right[x] = p;
+        } else {
+            let b = self.left[x];
+            self.right[p] = b;
+            if b != K_NONE {
+                self.parent[b] = p;
+            }
+            self.left[x] = p;
+        }
+        self.parent[p] = x;
+        self.parent[x] = g;
+        self.replace_child(g, p, x);
+    }
+
+    ///Inserts edge, where is_left(other) tells whether other lies left of it.
+    fn insert(&mut self, edge: usize, mut is_left: impl FnMut(usize) -> bool) {
+        self.left[edge] = K_NONE;
+        self.right[edge] = K_NONE;
+        self.in_tree[edge] = true;
+        if self.root == K_NONE {
+            self.root = edge;
+            self.parent[edge] = K_NONE;
+            return;
+        }
+        let mut current = self.root;
+        loop {
+            let child = if is_left(current) {
+                &mut self.right[current]
+            } else {
+                &mut self.left[current]
+            };
+            if *child == K_NONE {
+                *child = edge;
+                break;
+            }
+            current = *child;
+        }
+        self.parent[edge] = current;
+        while self.parent[edge] != K_NONE
+            && Self::priority(self.parent[edge]) < Self::priority(edge)
+        {
+            self.rotate_up(edge);
+        }
+    }
+
+    fn remove(&mut self, edge: usize) {
+        loop {
+            let (l, r) = (self.left[edge], self.right[edge]);
+            let child = if l == K_NONE {
+                r
+            } else if r == K_NONE || Self::priority(l) > Self::priority(r) {
+                l
+            } else {
+                r
+            };
+            if child == K_NONE {
+                break;
+            }
+            self.rotate_up(child);
+        }
+        self.replace_child(self.parent[edge], edge, K_NONE);
+        self.in_tree[edge] = false;
+    }
+
+    ///The rightmost edge for which is_left() holds, which must be true for a
+    ///prefix of the edges.
+    fn rightmost(&self, mut is_left: impl FnMut(usize) -> bool) -> usize {
+        let mut best = K_NONE;
+        let mut current = self.root;
+        while current != K_NONE {
+            if is_left(current) {
+                best = current;
+                current = self.right[current];
+            } else {
+                current = self.left[current];
+            }
+        }
+        best
+    }
+}
+
+///Flat storage of the input contours as circular lists.
+struct Contours {
+    pos: Vec<Point2<f64>>,
+    mesh_idx: Vec<i32>,
+    next: Vec<usize>,
+    prev: Vec<usize>,
+}
+
+///Sweep-line triangulator: diagonals from each split and merge vertex divide
+///the polygons into y-monotone pieces, which are each triangulated in linear
+///time with a stack. O(n log n) overall, regardless of shape, but without the
+///triangle quality heuristics of the ear-clipper and without its handling of
+///degenerate or overlapping input.
+///
+///Returns None whenever the input is not handled, e.g. repeated vertex
+///positions or zero-area contours, or the result fails validation against
+///epsilon, in which case the caller should fall back to ear-clipping. A
+///returned triangulation is manifold, matches the input edge directions, and
+///has no triangle that is inverted by more than epsilon.
+pub(crate) fn triangulate_monotone(polys: &PolygonsIdx, epsilon: f64) -> Option<Vec<Vector3<i32>>> {
+    let contours = flatten(polys)?;
+    let n = contours.pos.len();
+    let pos = &contours.pos;
+    let next = &contours.next;
+    let prev = &contours.prev;
+
+    let mut bbox = Rect::default();
+    for &p in pos {
+        bbox.union(p);
+    }
+    let epsilon = if epsilon < 0.0 {
+        bbox.scale() * K_PRECISION
+    } else {
+        epsilon
+    };
+
+    let mut order: Vec<usize> = (0..n).collect();
+    order.sort_unstable_by(|&a, &b| sweep_cmp(pos[a], pos[b]));
+    if order.windows(2).any(|w| pos[w[0]] == pos[w[1]]) {
+        return None;
+    }
+    let mut rank = vec![0; n];
+    for (i, &v) in order.iter().enumerate() {
+        rank[v] = i;
+    }
+
+    let mut vert_type = Vec::with_capacity(n);
+    for v in 0..n {
+        let (p, q) = (pos[prev[v]], pos[next[v]]);
+        let turn = orient(p, pos[v], q);
+        let t = if above(pos[v], p) && above(pos[v], q) {
+            if turn == 0.0 {
+                return None;
+            }
+            if turn > 0.0 { VertType::Start } else { VertType::Split }
+        } else if above(p, pos[v]) && above(q, pos[v]) {
+            if turn == 0.0 {
+                return None;
+            }
+            if turn > 0.0 { VertType::End } else { VertType::Merge }
+        } else {
+            VertType::Regular
+        };
+        vert_type.push(t);
+    }
+
+    let diagonals = monotone_diagonals(&contours, &order, &vert_type)?;
+    let (face_verts, face_start) = monotone_faces(&contours, &diagonals)?;
+
+    let mut triangles = Vec::with_capacity(n + 2 * polys.len());
+    let mut sorted = Vec::new();
+    let mut stack = Vec::new();
+    for face in face_start.windows(2) {
+        let face = &face_verts[face[0]..face[1]];
+        triangulate_monotone_face(
+            face,
+            pos,
+            &rank,
+            epsilon,
+            &mut sorted,
+            &mut stack,
+            &mut triangles,
+        )?;
+    }
+
+    if !is_valid(&contours, polys, &triangles, epsilon) {
+        return None;
+    }
+    Some(
+        triangles
+            .iter()
+            .map(|tri| tri.map(|v| contours.mesh_idx[v as usize]))
+            .collect(),
+    )
+}
+
+fn flatten(polys: &PolygonsIdx) -> Option<Contours> {
+    let num_vert = polys.iter().map(|poly| poly.len()).sum();
+    let mut contours = Contours {
+        pos: Vec::with_capacity(num_vert),
+        mesh_idx: Vec::with_capacity(num_vert),
+        next: Vec::with_capacity(num_vert),
+        prev: Vec::with_capacity(num_vert),
+    };
+    for poly in polys {
+        if poly.len() < 3 {
+            return None;
+        }
+        let first = contours.pos.len();
+        let last = first + poly.len() - 1;
+        for (i, vert) in poly.iter().enumerate() {
+            let v = first + i;
+            contours.pos.push(vert.pos);
+            contours.mesh_idx.push(vert.idx);
+            contours.next.push(if v == last { first } else { v + 1 });
+            contours.prev.push(if v == first { last } else { v - 1 });
+        }
+    }
+    Some(contours)
+}
+
+///Sweeps the vertices in order, adding a diagonal from each split vertex up to
+///the helper of the edge to its left, and from each merge vertex down to the
+///next helper that replaces it.
+fn monotone_diagonals(
+    contours: &Contours,
+    order: &[usize],
+    vert_type: &[VertType],
+) -> Option<Vec<(usize, usize)>> {
+    let pos = &contours.pos;
+    let next = &contours.next;
+    let prev = &contours.prev;
+    // Edge e runs from vert e to next[e].
+    let mut status = SweepStatus::new(pos.len());
+    let mut helper = vec![K_NONE; pos.len()];
+    let mut diagonals = Vec::new();
+
+    for &v in order {
+        let p = pos[v];
+        let left_of_v = |e: usize| orient(pos[e], pos[next[e]], p) > 0.0;
+        let left_of_edge_v = |e: usize| {
+            let side = orient(pos[e], pos[next[e]], p);
+            side > 0.0 || (side == 0.0 && orient(pos[e], pos[next[e]], pos[next[v]]) > 0.0)
+        };
+        let end_edge = |status: &mut SweepStatus, e: usize, diagonals: &mut Vec<_>| {
+            if !status.in_tree[e] {
+                return false;
+            }
+            if vert_type[helper[e]] == VertType::Merge {
+                diagonals.push((v, helper[e]));
+            }
+            status.remove(e);
+            true
+        };
+
+        match vert_type[v] {
+            VertType::Start => {
+                status.insert(v, left_of_edge_v);
+                helper[v] = v;
+            }
+            VertType::End => {
+                if !end_edge(&mut status, prev[v], &mut diagonals) {
+                    return None;
+                }
+            }
+            VertType::Split => {
+                let e = status.rightmost(left_of_v);
+                if e == K_NONE {
+                    return None;
+                }
+                diagonals.push((v, helper[e]));
+                helper[e] = v;
+                status.insert(v, left_of_edge_v);
+                helper[v] = v;
+            }
+            VertType::Merge => {
+                if !end_edge(&mut status, prev[v], &mut diagonals) {
+                    return None;
+                }
+                let e = status.rightmost(left_of_v);
+                if e == K_NONE {
+                    return None;
+                }
+                if vert_type[helper[e]] == VertType::Merge {
+                    diagonals.push((v, helper[e]));
+                }
+                helper[e] = v;
+            }
+            VertType::Regular => {
+                if above(pos[prev[v]], p) {
+                    // The interior is to the right of v.
+                    if !end_edge(&mut status, prev[v], &mut diagonals) {
+                        return None;
+                    }
+                    status.insert(v, left_of_edge_v);
+                    helper[v] = v;
+                } else {
+                    let e = status.rightmost(left_of_v);
+                    if e == K_NONE {
+                        return None;
+                    }
+                    if vert_type[helper[e]] == VertType::Merge {
+                        diagonals.push((v, helper[e]));
+                    }
+                    helper[e] = v;
+                }
+            }
+        }
+    }
+    Some(diagonals)
+}
+
+///Angle of d, monotone in [0, 4) counterclockwise from +x.
+fn pseudo_angle(d: nalgebra::Vector2<f64>) -> f64 {
+    let p = d.y / (d.x.abs() + d.y.abs());
+    if d.x < 0.0 {
+        2.0 - p
+    } else if d.y < 0.0 {
+        4.0 + p
+    } else {
+        p
+    }
+}
+
+///Splits the polygons along the diagonals, returning the vertex loops of the
+///resulting faces, counterclockwise, concatenated, along with the offset of
+///each loop followed by the total length.
+fn monotone_faces(
+    contours: &Contours,
+    diagonals: &[(usize, usize)],
+) -> Option<(Vec<usize>, Vec<usize>)> {
+    let pos = &contours.pos;
+    let n = pos.len();
+    // Halfedge h < n is the polygon edge out of vert h; diagonals follow, in
+    // both directions.
+    let mut from: Vec<usize> = (0..n).collect();
+    let mut to = contours.next.clone();
+    for &(a, b) in diagonals {
+        from.extend([a, b]);
+        to.extend([b, a]);
+    }
+
+    let mut out_start = vec![0; n + 1];
+    for &v in &from {
+        out_start[v + 1] += 1;
+    }
+    for v in 0..n {
+        out_start[v + 1] += out_start[v];
+    }
+    let mut fill = out_start.clone();
+    let mut out = vec![0; from.len()];
+    for (h, &v) in from.iter().enumerate() {
+        out[fill[v]] = h;
+        fill[v] += 1;
+    }
+
+    // The face continues along the outgoing halfedge with the smallest
+    // clockwise turn from the reverse of the incoming one.
+    let next_halfedge = |h: usize| {
+        let v = to[h];
+        let outgoing = &out[out_start[v]..out_start[v + 1]];
+        if outgoing.len() == 1 {
+            return outgoing[0];
+        }
+        let back = pseudo_angle(pos[from[h]] - pos[v]);
+        let mut best = K_NONE;
+        let mut best_turn = f64::INFINITY;
+        for &o in outgoing {
+            let mut turn = back - pseudo_angle(pos[to[o]] - pos[v]);
+            if turn <= 0.0 {
+                turn += 4.0;
+            }
+            if turn < best_turn {
+                best_turn = turn;
+                best = o;
+            }
+        }
+        best
+    };
+
+    let mut visited = vec![false; from.len()];
+    let mut face_verts = Vec::with_capacity(from.len());
+    let mut face_start = Vec::with_capacity(diagonals.len() + 2);
+    for first in 0..from.len() {
+        if visited[first] {
+            continue;
+        }
+        face_start.push(face_verts.len());
+        let mut h = first;
+        while !visited[h] {
+            visited[h] = true;
+            face_verts.push(from[h]);
+            h = next_halfedge(h);
+        }
+        if h != first {
+            return None;
+        }
+    }
+    face_start.push(face_verts.len());
+    Some((face_verts, face_start))
+}
+
+///Triangulates a y-monotone face in linear time, checking convexity with
+///epsilon so that near-colinear chains are fanned rather than clipped. sorted
+///and stack are scratch space, reused between faces.
+fn triangulate_monotone_face(
+    face: &[usize],
+    pos: &[Point2<f64>],
+    rank: &[usize],
+    epsilon: f64,
+    sorted: &mut Vec<(usize, bool)>,
+    stack: &mut Vec<(usize, bool)>,
+    triangles: &mut Vec<Vector3<i32>>,
+) -> Option<()> {
+    let k = face.len();
+    if k < 3 {
+        return None;
+    }
+    if k == 3 {
+        triangles.push(Vector3::new(face[0] as i32, face[1] as i32, face[2] as i32));
+        return Some(());
+    }
+
+    let top = (0..k).min_by_key(|&i| rank[face[i]]).unwrap();
+    let bottom = (0..k).max_by_key(|&i| rank[face[i]]).unwrap();
+
+    // The left chain runs forward from top to bottom and the right chain
+    // backward; merge them into sweep order, flagging the left chain.
+    sorted.clear();
+    sorted.push((face[top], true));
+    let mut l = (top + 1) % k;
+    let mut r = (top + k - 1) % k;
+    while l != bottom || r != bottom {
+        let take_left = r == bottom || (l != bottom && rank[face[l]] < rank[face[r]]);
+        let (i, is_left) = if take_left { (l, true) } else { (r, false) };
+        sorted.push((face[i], is_left));
+        if take_left {
+            l = (l + 1) % k;
+        } else {
+            r = (r + k - 1) % k;
+        }
+    }
+    sorted.push((face[bottom], true));
+    // The face is only monotone if each chain descends on its own.
+    for chain in [true, false] {
+        let mut last = 0;
+        for &(v, is_left) in &sorted[1..k - 1] {
+            if is_left == chain {
+                if rank[v] < last {
+                    return None;
+                }
+                last = rank[v];
+            }
+        }
+    }
+
+    // Emits the triangle of u and the upper and lower stack verts a and b,
+    // where b and u are on the chain given by is_left.
+    let mut emit = |a: usize, b: usize, u: usize, is_left: bool| {
+        let tri = if is_left {
+            Vector3::new(a, b, u)
+        } else {
+            Vector3::new(u, b, a)
+        };
+        triangles.push(tri.map(|v| v as i32));
+    };
+
+    stack.clear();
+    stack.extend([sorted[0], sorted[1]]);
+    for &(u, u_left) in &sorted[2..k - 1] {
+        let &(top_v, top_left) = stack.last().unwrap();
+        if u_left != top_left {
+            // Fan across to the whole other chain.
+            for w in stack.windows(2) {
+                emit(w[0].0, w[1].0, u, !u_left);
+            }
+            stack.clear();
+            stack.push((top_v, top_left));
+        } else {
+            let mut last = stack.pop().unwrap();
+            while let Some(&upper) = stack.last() {
+                let convex = if u_left {
+                    ccw(pos[upper.0], pos[last.0], pos[u], epsilon) > 0
+                } else {
+                    ccw(pos[u], pos[last.0], pos[upper.0], epsilon) > 0
+                };
+                if !convex {
+                    break;
+                }
+                emit(upper.0, last.0, u, u_left);
+                last = stack.pop().unwrap();
+            }
+            stack.push(last);
+        }
+        stack.push((u, u_left));
+    }
+
+    let bottom_v = sorted[k - 1].0;
+    for w in stack.windows(2) {
+        emit(w[0].0, w[1].0, bottom_v, w[1].1);
+    }
+    Some(())
+}
+
+///Checks the triangle count, that no triangle is inverted beyond epsilon, and
+///that every polygon edge is used once and every diagonal twice, in opposite
+///directions.
+fn is_valid(
+    contours: &Contours,
+    polys: &PolygonsIdx,
+    triangles: &[Vector3<i32>],
+    epsilon: f64,
+) -> bool {
+    let pos = &contours.pos;
+    let n = pos.len();
+    let mut expected = n as i64;
+    for poly in polys {
+        let area: f64 = (0..poly.len())
+            .map(|i| poly[i].pos.coords.perp(&poly[(i + 1) % poly.len()].pos.coords))
+            .sum();
+        expected += if area > 0.0 { -2 } else { 2 };
+    }
+    if triangles.len() as i64 != expected {
+        return false;
+    }
+
+    let mut edges = Vec::with_capacity(3 * triangles.len());
+    for tri in triangles {
+        let [a, b, c] = [tri[0], tri[1], tri[2]].map(|v| v as usize);
+        if ccw(pos[a], pos[b], pos[c], epsilon) < 0 {
+            return false;
+        }
+        edges.extend([(a, b), (b, c), (c, a)]);
+    }
+    edges.sort_unstable();
+    if edges.windows(2).any(|w| w[0] == w[1]) {
+        return false;
+    }
+    let mut num_boundary = 0;
+    for &(a, b) in &edges {
+        if contours.next[a] == b {
+            num_boundary += 1;
+        } else if edges.binary_search(&(b, a)).is_err() {
+            return false;
+        }
+    }
+    num_boundary == n
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::polygon::{PolyVert, SimplePolygonIdx, Triangulator, triangulate_idx_with};
+
+    fn polygon(points: &[(f64, f64)], first_idx: i32) -> SimplePolygonIdx {
+        points
+            .iter()
+            .enumerate()
+            .map(|(i, &(x, y))| PolyVert {
+                pos: Point2::new(x, y),
+                idx: first_idx + i as i32,
+            })
+            .collect()
+    }
+
+    fn area(polys: &PolygonsIdx, triangles: &[Vector3<i32>]) -> f64 {
+        let pos: Vec<Point2<f64>> = polys.iter().flatten().map(|v| v.pos).collect();
+        triangles
+            .iter()
+            .map(|tri| 0.5 * orient(pos[tri[0] as usize], pos[tri[1] as usize], pos[tri[2] as usize]))
+            .sum()
+    }
+
+    #[test]
+    fn comb_with_holes() {
+        // A comb with teeth pointing up and down, so that it has many split and
+        // merge verts, plus a row of square holes in its spine.
+        let teeth = 50;
+        let mut outline = Vec::new();
+        for i in 0..teeth {
+            let x = 4.0 * i as f64;
+            outline.extend([(x, -1.0), (x + 1.0, -1.0), (x + 1.0, -10.0), (x + 3.0, -10.0)]);
+        }
+        outline.push((4.0 * teeth as f64, -10.0));
+        outline.push((4.0 * teeth as f64, 10.0));
+        for i in (0..teeth).rev() {
+            let x = 4.0 * i as f64;
+            outline.extend([(x + 3.0, 10.0), (x + 3.0, 1.0), (x + 2.0, 1.0), (x + 2.0, 10.5)]);
+        }
+        outline.push((0.0, 10.0));
+        let mut polys = vec![polygon(&outline, 0)];
+        for i in 0..teeth {
+            let x = 4.0 * i as f64 + 1.5;
+            let first = polys.iter().map(|p| p.len()).sum::<usize>() as i32;
+            polys.push(polygon(
+                &[(x, -0.5), (x, 0.5), (x + 1.0, 0.5), (x + 1.0, -0.5)],
+                first,
+            ));
+        }
+
+        let triangles = triangulate_monotone(&polys, -1.0).expect("monotone triangulation failed");
+        let expected: f64 = polys
+            .iter()
+            .map(|poly| {
+                (0..poly.len())
+                    .map(|i| 0.5 * poly[i].pos.coords.perp(&poly[(i + 1) % poly.len()].pos.coords))
+                    .sum::<f64>()
+            })
+            .sum();
+        assert!((area(&polys, &triangles) - expected).abs() < 1e-9);
+    }
+
+    #[test]
+    fn large_outline_without_fallback() {
+        // The outline of test_polygon_extrude_large_outline. Asking for the
+        // monotone backend must return the sweep's own triangles, not an
+        // ear-clipped fallback.
+        let n = 12000;
+        let outline: Vec<(f64, f64)> = (0..n)
+            .map(|i| {
+                let angle = 2.0 * std::f64::consts::PI * i as f64 / n as f64;
+                let radius = if i % 3 == 0 { 0.8 } else { 1.0 };
+                (radius * angle.cos(), radius * angle.sin())
+            })
+            .collect();
+        let polys = vec![polygon(&outline, 0)];
+
+        let triangles = triangulate_monotone(&polys, -1.0).expect("monotone triangulation failed");
+        assert_eq!(
+            triangulate_idx_with(&polys, -1.0, false, Triangulator::Monotone),
+            triangles
+        );
+        assert_eq!(triangles.len(), n - 2);
+
+        // Every outline edge is used once in its own direction and every
+        // diagonal once in each direction.
+        let mut edges = std::collections::HashMap::new();
+        for tri in &triangles {
+            for i in 0..3 {
+                *edges.entry((tri[i], tri[(i + 1) % 3])).or_insert(0) += 1;
+            }
+        }
+        for (&(v0, v1), &count) in &edges {
+            assert_eq!(count, 1);
+            let outline_edge = (v0 + 1) % n as i32 == v1;
+            assert_eq!(edges.contains_key(&(v1, v0)), !outline_edge);
+        }
+
+        let pos: Vec<Point2<f64>> = polys[0].iter().map(|v| v.pos).collect();
+        for tri in &triangles {
+            assert!(orient(pos[tri[0] as usize], pos[tri[1] as usize], pos[tri[2] as usize]) > 0.0);
+        }
+        let expected: f64 = (0..n)
+            .map(|i| 0.5 * pos[i].coords.perp(&pos[(i + 1) % n].coords))
+            .sum();
+        assert!((area(&polys, &triangles) - expected).abs() < 1e-9);
+    }
+
+    #[test]
+    fn rejects_repeated_verts() {
+        let polys = vec![polygon(
+            &[(0.0, 0.0), (2.0, 0.0), (1.0, 1.0), (2.0, 2.0), (0.0, 2.0), (1.0, 1.0)],
+            0,
+        )];
+        assert!(triangulate_monotone(&polys, -1.0).is_none());
+    }
+}
@@ -0,0 +1,311 @@
+use crate::meshboolimpl::MeshBoolImpl;
+use crate::{MeshGL64, mesh_gl_chunks};
+use std::collections::HashMap;
+use std::io::{self, BufRead, BufReader, Read, Write};
+
+///Triangles written per chunk, bounding the memory used by write_obj().
+const CHUNK_TRIS: usize = 1 << 14;
+
+///The material name that resets "usemtl" to none, as other OBJ writers use.
+const NO_MATERIAL: &str = "(null)";
+
+///The OBJ group and material of the triangles of one original mesh.
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct ObjGroup {
+    /// The name given by the last "g" or "o" statement, or empty.
+    pub name: String,
+    /// The name given by the last "usemtl" statement, or empty for none or
+    /// "(null)".
+    pub material: String,
+    /// The originalID of these triangles' runs.
+    pub original_id: u32,
+}
+
+///How a manifold's runs and property channels correspond to OBJ groups and
+///vertex attributes, as returned by read_obj() and used by write_obj().
+#[derive(Clone, Debug, Default, PartialEq, Eq)]
+pub struct ObjLayout {
+    /// The group and material of each originalID.
+    pub groups: Vec<ObjGroup>,
+    /// The first of two property channels holding texture coordinates (vt).
+    pub uv_idx: Option<usize>,
+    /// The first of three property channels holding normals (vn).
+    pub normal_idx: Option<usize>,
+}
+
+fn invalid(line: usize, msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, format!("invalid OBJ, line {line}: {msg}"))
+}
+
+///Parses the numbers of a "v", "vt" or "vn" statement into out, ignoring any
+///beyond its length, such as vertex colors.
+fn parse_values<'a>(
+    tokens: impl Iterator<Item = &'a str>,
+    out: &mut Vec<f64>,
+    len: usize,
+    line: usize,
+) -> io::Result<()> {
+    let start = out.len();
+    for token in tokens.take(len) {
+        out.push(token.parse().map_err(|_| invalid(line, "bad number"))?);
+    }
+    if out.len() - start < len {
+        return Err(invalid(line, "too few values"));
+    }
+    Ok(())
+}
+
+///Resolves a one-based, or negative relative, OBJ index into a list of count.
+fn parse_index(token: &str, count: usize, line: usize) -> io::Result<usize> {
+    let idx: i64 = token.parse().map_err(|_| invalid(line, "bad index"))?;
+    let resolved = if idx < 0 { count as i64 + idx } else { idx - 1 };
+    if resolved < 0 || resolved >= count as i64 {
+        return Err(invalid(line, "index out of bounds"));
+    }
+    Ok(resolved as usize)
+}
+
+impl MeshBoolImpl {
+    pub(crate) fn read_obj<R: Read>(reader: R) -> io::Result<(MeshBoolImpl, ObjLayout)> {
+        let mut reader = BufReader::with_capacity(1 << 16, reader);
+        let mut positions: Vec<f64> = Vec::new();
+        let mut uvs: Vec<f64> = Vec::new();
+        let mut normals: Vec<f64> = Vec::new();
+
+        // Each distinct (v, vt, vn) triple becomes a vert; missing attributes
+        // are usize::MAX.
+        let mut corner2vert: HashMap<[usize; 3], u32> = HashMap::new();
+        let mut corners: Vec<[usize; 3]> = Vec::new();
+        // Triangles, then the block and polygon of each.
+        let mut tris: Vec<[u32; 3]> = Vec::new();
+        let mut tri_block: Vec<u32> = Vec::new();
+        let mut tri_face: Vec<u32> = Vec::new();
+        let mut num_face = 0;
+
+        let mut blocks: Vec<(String, String)> = Vec::new();
+        let mut block_idx: HashMap<(String, String), u32> = HashMap::new();
+        let (mut group, mut material) = (String::new(), String::new());
+        let mut block = None;
+
+        let mut polygon: Vec<u32> = Vec::new();
+        let mut text = String::new();
+        let mut line = 0;
+        while reader.read_line(&mut text)? > 0 {
+            line += 1;
+            let mut tokens = text.split_ascii_whitespace();
+            match tokens.next() {
+                Some("v") => parse_values(tokens, &mut positions, 3, line)?,
+                Some("vt") => parse_values(tokens, &mut uvs, 2, line)?,
+                Some("vn") => parse_values(tokens, &mut normals, 3, line)?,
+                Some(kind @ ("g" | "o" | "usemtl")) => {
+                    let name = tokens.collect::<Vec<_>>().join(" ");
+                    if kind == "usemtl" {
+                        material = if name == NO_MATERIAL { String::new() } else { name };
+                    } else {
+                        group = name;
+                    }
+                    block = None;
+                }
+                Some("f") => {
+                    polygon.clear();
+                    for token in tokens {
+                        let mut idx = token.split('/');
+                        let mut corner = [usize::MAX; 3];
+                        let counts = [positions.len() / 3, uvs.len() / 2, normals.len() / 3];
+                        for (i, count) in counts.into_iter().enumerate() {
+                            match idx.next() {
+                                Some(token) if i == 0 || !token.is_empty() => {
+                                    corner[i] = parse_index(token, count, line)?
+                                }
+                                _ => {}
+                            }
+                        }
+                        let num_vert = corners.len() as u32;
+                        polygon.push(*corner2vert.entry(corner).or_insert_with(|| {
+                            corners.push(corner);
+                            num_vert
+                        }));
+                    }
+                    if polygon.len() < 3 {
+                        return Err(invalid(line, "faces need at least three vertices"));
+                    }
+
+                    let block = *block.get_or_insert_with(|| {
+                        let key = (group.clone(), material.clone());
+                        *block_idx.entry(key).or_insert_with_key(|key| {
+                            blocks.push(key.clone());
+                            blocks.len() as u32 - 1
+                        })
+                    });
+                    // Polygons are fanned, and their triangles share a face ID.
+                    for i in 1..polygon.len() - 1 {
+                        tris.push([polygon[0], polygon[i], polygon[i + 1]]);
+                        tri_block.push(block);
+                        tri_face.push(num_face);
+                    }
+                    num_face += 1;
+                }
+                _ => {}
+            }
+            text.clear();
+        }
+        drop(corner2vert);
+
+        let has_uv = corners.iter().any(|c| c[1] != usize::MAX);
+        let has_normal = corners.iter().any(|c| c[2] != usize::MAX);
+        let layout_uv = has_uv.then_some(0);
+        let layout_normal = has_normal.then_some(2 * has_uv as usize);
+        let num_prop = 3 + 2 * has_uv as usize + 3 * has_normal as usize;
+
+        // Every vert is merged to the first one sharing its position.
+        let mut mesh_gl = MeshGL64 {
+            num_prop: num_prop as u32,
+            ..Default::default()
+        };
+        mesh_gl.vert_properties.reserve(num_prop * corners.len());
+        let mut position2vert = vec![u32::MAX; positions.len() / 3];
+        for (vert, &[p, t, n]) in corners.iter().enumerate() {
+            mesh_gl.vert_properties.extend_from_slice(&positions[3 * p..3 * p + 3]);
+            if has_uv {
+                let uv = if t == usize::MAX { &[0.0; 2] } else { &uvs[2 * t..2 * t + 2] };
+                mesh_gl.vert_properties.extend_from_slice(uv);
+            }
+            if has_normal {
+                let normal = if n == usize::MAX { &[0.0; 3] } else { &normals[3 * n..3 * n + 3] };
+                mesh_gl.vert_properties.extend_from_slice(normal);
+            }
+            if position2vert[p] == u32::MAX {
+                position2vert[p] = vert as u32;
+            } else {
+                mesh_gl.merge_from_vert.push(vert as u64);
+                mesh_gl.merge_to_vert.push(position2vert[p] as u64);
+            }
+        }
+        drop(position2vert);
+
+        // Sort the triangles into one run per block by counting.
+        let mut run_start = vec![0; blocks.len() + 1];
+        for &block in &tri_block {
+            run_start[block as usize + 1] += 1;
+        }
+        for run in 1..run_start.len() {
+            run_start[run] += run_start[run - 1];
+        }
+        let first_id = MeshBoolImpl::reserve_ids(blocks.len()) as u32;
+        mesh_gl.run_index = run_start.iter().map(|&start| 3 * start as u64).collect();
+        mesh_gl.run_original_id = (first_id..first_id + blocks.len() as u32).collect();
+        mesh_gl.tri_verts = vec![0; 3 * tris.len()];
+        mesh_gl.face_id = vec![0; tris.len()];
+        for (tri, verts) in tris.iter().enumerate() {
+            let new_tri = run_start[tri_block[tri] as usize];
+            run_start[tri_block[tri] as usize] += 1;
+            for i in 0..3 {
+                mesh_gl.tri_verts[3 * new_tri + i] = verts[i] as u64;
+            }
+            mesh_gl.face_id[new_tri] = tri_face[tri] as u64;
+        }
+        if blocks.is_empty() {
+            mesh_gl.run_index.clear();
+        }
+
+        // Welding is only needed if positions were repeated.
+        mesh_gl.merge();
+        let groups = blocks
+            .into_iter()
+            .zip(first_id..)
+            .map(|((name, material), original_id)| ObjGroup {
+                name,
+                material,
+                original_id,
+            })
+            .collect();
+        let layout = ObjLayout {
+            groups,
+            uv_idx: layout_uv,
+            normal_idx: layout_normal,
+        };
+        Ok((MeshBoolImpl::from_mesh_gl(&mesh_gl), layout))
+    }
+
+    pub(crate) fn write_obj<W: Write>(&self, layout: &ObjLayout, writer: &mut W) -> io::Result<()> {
+        let num_prop = self.num_prop();
+        let check = |idx: Option<usize>, len: usize| idx.is_none_or(|i| i + len <= num_prop);
+        if !check(layout.uv_idx, 2) || !check(layout.normal_idx, 3) {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidInput,
+                "layout channels exceed the properties",
+            ));
+        }
+
+        let mut buffer: Vec<u8> = Vec::new();
+        let normal_idx = layout.normal_idx.map_or(-1, |i| i as i32);
+        let mut chunks = mesh_gl_chunks::<f64, u64>(self, normal_idx, CHUNK_TRIS);
+        let mut chunk = MeshGL64::default();
+        let mut first_tri = 0;
+        // Runs whose headers are due: (first triangle, originalID).
+        let mut runs: Vec<(usize, u32)> = Vec::new();
+        let mut group = None;
+        let mut material = String::new();
+        while chunks.next_into(&mut chunk) {
+            let stride = chunk.num_prop as usize;
+            for vert in chunk.vert_properties.chunks_exact(stride) {
+                writeln!(buffer, "v {} {} {}", vert[0], vert[1], vert[2])?;
+                if let Some(i) = layout.uv_idx {
+                    writeln!(buffer, "vt {} {}", vert[3 + i], vert[4 + i])?;
+                }
+                if let Some(i) = layout.normal_idx {
+                    writeln!(buffer, "vn {} {} {}", vert[3 + i], vert[4 + i], vert[5 + i])?;
+                }
+            }
+
+            runs.extend(
+                chunk
+                    .run_index
+                    .iter()
+                    .zip(&chunk.run_original_id)
+                    .map(|(&start, &id)| (start as usize / 3, id)),
+            );
+            let mut next_run = 0;
+            for (i, tri) in chunk.tri_verts.chunks_exact(3).enumerate() {
+                // Empty runs are skipped, as only the last starting here counts.
+                let mut original_id = None;
+                while next_run < runs.len() && runs[next_run].0 <= first_tri + i {
+                    original_id = Some(runs[next_run].1);
+                    next_run += 1;
+                }
+                if let Some(id) = original_id {
+                    let found = layout.groups.iter().find(|g| g.original_id == id);
+                    let name = found.map_or(format!("original_{id}"), |g| g.name.clone());
+                    if group.as_ref() != Some(&name) {
+                        writeln!(buffer, "g {name}")?;
+                        group = Some(name);
+                    }
+                    // A run without a material has to reset the previous one.
+                    let mtl = found.map(|g| g.material.as_str()).unwrap_or_default();
+                    if material != mtl {
+                        let name = if mtl.is_empty() { NO_MATERIAL } else { mtl };
+                        writeln!(buffer, "usemtl {name}")?;
+                        material = mtl.to_string();
+                    }
+                }
+
+                write!(buffer, "f")?;
+                for &vert in tri {
+                    let v = vert + 1;
+                    match (layout.uv_idx, layout.normal_idx) {
+                        (None, None) => write!(buffer, " {v}")?,
+                        (Some(_), None) => write!(buffer, " {v}/{v}")?,
+                        (None, Some(_)) => write!(buffer, " {v}//{v}")?,
+                        (Some(_), Some(_)) => write!(buffer, " {v}/{v}/{v}")?,
+                    }
+                }
+                writeln!(buffer)?;
+            }
+            runs.drain(..next_run);
+            first_tri += chunk.tri_verts.len() / 3;
+            writer.write_all(&buffer)?;
+            buffer.clear();
+        }
+        Ok(())
+    }
+}
@@ -1,4 +1,5 @@
 use crate::common::{OrderedF64, Rect};
+use crate::monotone::triangulate_monotone;
 use crate::tree2d::{build_2d_tree, query_2d_tree};
 use crate::utils::{K_PRECISION, ccw};
 use crate::vec::InsertSorted;
@@ -6,7 +7,7 @@ use nalgebra::{Matrix2, Point2, Vector2, Vector3};
 use std::cmp::Reverse;
 use std::collections::BTreeMap;
 use std::ops::Range;
-use std::{collections::VecDeque, mem, ptr};
+use std::{mem, ptr};
 
 struct CutKeyholeParams<'a> {
     simples: &'a mut Vec<usize>,
@@ -14,6 +15,7 @@ struct CutKeyholeParams<'a> {
     polygon: &'a mut Vec<Vert>,
     polygon_range: &'a Range<usize>,
     outers: &'a Vec<usize>,
+    outer_bbox: &'a mut Vec<Rect>,
     hole2bbox: &'a BTreeMap<usize, Rect>,
     epsilon: f64,
 }
@@ -21,6 +23,10 @@ struct CutKeyholeParams<'a> {
 
 const K_BEST: f64 = f64::NEG_INFINITY;
 
+///Above this many vertices, triangulate_idx() tries the O(n log n) monotone
+///sweep before ear-clipping, trading triangle quality for speed.
+const K_MONOTONE_MIN_VERTS: usize = 10_000;
+
 ///Polygon vertex.
 #[derive(Debug)]
 pub struct PolyVert {
@@ -93,6 +99,8 @@ struct EarClip {
     holes: Vec<usize>,
     /// The set of starting points, one for each positive-area contour.
     outers: Vec<usize>,
+    /// Bounding box of each outer contour, grown as holes are joined to it.
+    outer_bbox: Vec<Rect>,
     /// The set of starting points, one for each simple polygon.
     simples: Vec<usize>,
     /// Maps each hole (by way of starting point) to its bounding box.
@@ -122,6 +130,7 @@ impl EarClip {
             polygon_range,
             holes: Vec::new(),
             outers: Vec::new(),
+            outer_bbox: Vec::new(),
             simples: Vec::new(),
             hole2bbox: BTreeMap::new(),
             triangles: Vec::default(),
@@ -170,6 +179,7 @@ impl EarClip {
                 polygon: &mut self.polygon,
                 polygon_range: &self.polygon_range,
                 outers: &self.outers,
+                outer_bbox: &mut self.outer_bbox,
                 hole2bbox: &self.hole2bbox,
                 epsilon: self.epsilon,
             };
@@ -180,11 +190,18 @@ impl EarClip {
         }
 
         drop(self.outers);
+        drop(self.outer_bbox);
         drop(self.hole2bbox);
 
+        // The collider's storage is reused for each simple polygon.
+        let mut vert_collider = IdxCollider {
+            points: Vec::new(),
+            itr: Vec::new(),
+        };
         for start in self.simples {
             Self::triangulate_poly(
                 start,
+                &mut vert_collider,
                 &mut self.polygon,
                 &self.polygon_range,
                 &mut self.triangles,
@@ -329,6 +346,7 @@ impl EarClip {
                 mesh_idx: vert.idx,
                 cost: 0.0,
                 ear: false,
+                queue_idx: 0,
                 pos: vert.pos,
                 right_dir: Vector2::new(0.0, 0.0),
                 left_idx: 0, // Will be set properly in the link function
@@ -352,6 +370,7 @@ impl EarClip {
                     mesh_idx: vert.idx,
                     cost: 0.0,
                     ear: false,
+                    queue_idx: 0,
                     pos: vert.pos,
                     right_dir: Vector2::new(0.0, 0.0),
                     left_idx: 0, // Will be set properly in the link function
@@ -420,6 +439,7 @@ impl EarClip {
             self.simples.push(start);
             if area > min_area {
                 self.outers.push(start);
+                self.outer_bbox.push(bbox);
             }
         }
     }
@@ -443,8 +463,9 @@ impl EarClip {
         };
 
         let mut connector: Option<usize> = None;
+        let mut connector_outer = 0;
 
-        let mut check_edge = |edge: usize, polygon: &mut Vec<Vert>| {
+        let mut check_edge = |edge: usize, polygon: &mut Vec<Vert>, outer: usize| {
             let edge = &polygon[edge];
             let start_ref = &polygon[start];
             let x = edge.interp_y2x(start_ref.pos, on_top, params.epsilon, polygon);
@@ -465,11 +486,23 @@ impl EarClip {
                 }))
             {
                 connector = Some(edge.ptr2index(params.polygon_range));
+                connector_outer = outer;
             }
         };
 
-        for &first in params.outers.iter() {
-            Self::loop_verts(first, params.polygon, params.polygon_range, &mut check_edge);
+        let start_y = params.polygon[start].pos.y;
+        for (outer, &first) in params.outers.iter().enumerate() {
+            // Only edges that cross the horizontal line through start can
+            // connect, so skip outers that don't reach it.
+            let outer_bbox = &params.outer_bbox[outer];
+            if outer_bbox.min.y > start_y + params.epsilon
+                || outer_bbox.max.y < start_y - params.epsilon
+            {
+                continue;
+            }
+            Self::loop_verts(first, params.polygon, params.polygon_range, |v, polygon| {
+                check_edge(v, polygon, outer)
+            });
         }
 
         if connector.is_none() {
@@ -478,29 +511,37 @@ impl EarClip {
             return;
         }
 
-        let connector = Self::find_closer_bridge(
+        let (connector, outer) = Self::find_closer_bridge(
             start,
             connector.unwrap(),
+            connector_outer,
             params.polygon,
             params.polygon_range,
             params.outers,
+            params.outer_bbox,
             params.epsilon,
         );
 
         Self::join_polygons(start, connector, params.polygon, params.polygon_range, params.triangles, params.epsilon);
+        // The hole is now part of this outer's loop.
+        params.outer_bbox[outer].union(bbox.min);
+        params.outer_bbox[outer].union(bbox.max);
     }
 
     ///This converts the initial guess for the keyhole location into the final one
-    ///and returns it. It does so by finding any reflex verts inside the triangle
-    ///containing the best connection and the initial horizontal line.
+    ///and returns it, along with the outer it belongs to. It does so by finding
+    ///any reflex verts inside the triangle containing the best connection and
+    ///the initial horizontal line.
     fn find_closer_bridge(
         start: usize,
         edge: usize,
+        edge_outer: usize,
         polygon: &mut Vec<Vert>,
         polygon_range: &Range<usize>,
         outers: &Vec<usize>,
+        outer_bbox: &[Rect],
         epsilon: f64,
-    ) -> usize {
+    ) -> (usize, usize) {
         let start_ref = &polygon[start];
         let edge_ref = &polygon[edge];
         let connector_ref = if edge_ref.pos.x < start_ref.pos.x {
@@ -514,14 +555,16 @@ impl EarClip {
         };
 
         let mut connector = connector_ref.ptr2index(polygon_range);
+        let mut connector_outer = edge_outer;
         if (connector_ref.pos.y - start_ref.pos.y).abs() <= epsilon {
-            return connector;
+            return (connector, connector_outer);
         }
+        let start_pos = start_ref.pos;
 
         let above_i32 = if connector_ref.pos.y > start_ref.pos.y { 1 } else { -1 };
         let above_f64 = above_i32 as f64;
 
-        let mut check_vert = |vert: usize, polygon: &mut Vec<Vert>| {
+        let mut check_vert = |vert: usize, polygon: &mut Vec<Vert>, outer: usize| {
             let vert = &polygon[vert];
             let start_ref = &polygon[start];
             let edge_ref = &polygon[edge];
@@ -539,14 +582,23 @@ impl EarClip {
                 && vert.is_reflexive(epsilon, polygon)
             {
                 connector = vert.ptr2index(polygon_range);
+                connector_outer = outer;
             }
         };
 
-        for &first in outers {
-            Self::loop_verts(first, polygon, polygon_range, &mut check_vert);
+        for (outer, &first) in outers.iter().enumerate() {
+            // Skip outers with no verts right of start on the connector's side.
+            let bbox = &outer_bbox[outer];
+            let y_max = if above_i32 > 0 { bbox.max.y } else { -bbox.min.y };
+            if bbox.max.x <= start_pos.x - epsilon || y_max <= start_pos.y * above_f64 - epsilon {
+                continue;
+            }
+            Self::loop_verts(first, polygon, polygon_range, |v, polygon| {
+                check_vert(v, polygon, outer)
+            });
         }
 
-        connector
+        (connector, connector_outer)
     }
 
     ///Creates a keyhole between the start vert of a hole and the connector vert
@@ -562,13 +614,21 @@ impl EarClip {
         epsilon: f64,
     ) {
         let new_start = polygon.len();
-        polygon.push(polygon[start].clone());
+        polygon.push(Vert {
+            self_idx: new_start,
+            ..polygon[start].clone()
+        });
         let new_connector = polygon.len();
-        polygon.push(polygon[connector].clone());
+        polygon.push(Vert {
+            self_idx: new_connector,
+            ..polygon[connector].clone()
+        });
 
-        // Update the links between vertices using indices
-        polygon[start].right_idx = new_start;
-        polygon[connector].left_idx = new_connector;
+        // start->right->left = newStart; connector->left->right = newConnector;
+        let start_right = polygon[start].right_idx;
+        polygon[start_right].left_idx = new_start;
+        let connector_left = polygon[connector].left_idx;
+        polygon[connector_left].right_idx = new_connector;
         Self::link(start, connector, polygon);
         Self::link(new_connector, new_start, polygon);
 
@@ -581,34 +641,40 @@ impl EarClip {
     fn process_ear(
         v: usize,
         collider: &IdxCollider,
-        ears_queue: &mut VecDeque<usize>,
+        ears_queue: &mut EarQueue,
         polygon: &mut Vec<Vert>,
         epsilon: f64,
     ) {
         if polygon[v].ear {
-            ears_queue.remove(ears_queue.iter().position(|&ball| ball == v).unwrap());
+            ears_queue.remove(v, polygon);
             polygon[v].ear = false;
         }
 
         if polygon[v].is_short(epsilon, polygon) {
             polygon[v].cost = K_BEST;
             polygon[v].ear = true;
-            ears_queue.insert_sorted_by_key(v, |&ear| OrderedF64(polygon[ear].cost)); //ascending cost
+            ears_queue.push(v, polygon);
         } else if polygon[v].is_convex(2.0 * epsilon, polygon) {
             polygon[v].cost = polygon[v].ear_cost(epsilon, collider, polygon);
             polygon[v].ear = true;
-            ears_queue.insert_sorted_by_key(v, |&ear| OrderedF64(polygon[ear].cost)); //ascending cost
+            ears_queue.push(v, polygon);
         } else {
             polygon[v].cost = 1.0; // not used, but marks reflex verts for debug
         }
     }
 
-    ///Create a collider of all vertices in this polygon, each expanded by
+    ///Fill a collider with all vertices in this polygon, each expanded by
     ///epsilon_. Each ear uses this BVH to quickly find a subset of vertices to
     ///check for cost.
-    fn vert_collider(start: usize, polygon: &mut Vec<Vert>, polygon_range: &Range<usize>) -> IdxCollider {
-        let mut itr = Vec::new();
-        let mut points = Vec::new();
+    fn vert_collider(
+        start: usize,
+        collider: &mut IdxCollider,
+        polygon: &mut Vec<Vert>,
+        polygon_range: &Range<usize>,
+    ) {
+        let IdxCollider { points, itr } = collider;
+        points.clear();
+        itr.clear();
         Self::loop_verts(start, polygon, polygon_range, |v, polygon| {
             points.push(PolyVert {
                 pos: polygon[v].pos,
@@ -618,20 +684,21 @@ impl EarClip {
             itr.push(v);
         });
 
-        build_2d_tree(&mut points);
-        IdxCollider { points, itr }
+        build_2d_tree(points);
     }
 
     ///The main ear-clipping loop. This is called once for each simple polygon -
     ///all holes have already been key-holed and joined to an outer polygon.
     fn triangulate_poly(
         start: usize,
+        vert_collider: &mut IdxCollider,
         polygon: &mut Vec<Vert>,
         polygon_range: &Range<usize>,
         triangles: &mut Vec<Vector3<i32>>,
         epsilon: f64,
     ) {
-        let vert_collider = Self::vert_collider(start, polygon, polygon_range);
+        Self::vert_collider(start, vert_collider, polygon, polygon_range);
+        let vert_collider = &*vert_collider;
 
         if vert_collider.itr.is_empty() {
             //empty poly
@@ -641,12 +708,11 @@ impl EarClip {
         // A simple polygon always creates two fewer triangles than it has verts.
         let mut num_tri = -2;
 
-        // A priority queue of valid ears - the multiset allows them to be updated.
-        //c++ uses multiset here, whose big o complexity is probably more desirable here
-        let mut ears_queue = VecDeque::new();
+        // A priority queue of valid ears - indexed so they can be updated.
+        let mut ears_queue = EarQueue::new();
 
         let queue_vert = |v, polygon: &mut Vec<Vert>| {
-            Self::process_ear(v, &vert_collider, &mut ears_queue, polygon, epsilon);
+            Self::process_ear(v, vert_collider, &mut ears_queue, polygon, epsilon);
             num_tri += 1;
         };
 
@@ -657,11 +723,9 @@ impl EarClip {
         let mut v = v.unwrap();
 
         while num_tri > 0 {
-            let ear = ears_queue.front();
-            if let Some(&ear) = ear {
-                v = ear;
+            if let Some(ear) = ears_queue.pop(polygon) {
                 // Cost should always be negative, generally < -epsilon.
-                ears_queue.pop_front();
+                v = ear;
             } else {
                 //no ear found!
             }
@@ -670,9 +734,9 @@ impl EarClip {
             num_tri -= 1;
 
             let ear_left = polygon[v].left(polygon).ptr2index(polygon_range);
-            Self::process_ear(ear_left, &vert_collider, &mut ears_queue, polygon, epsilon);
+            Self::process_ear(ear_left, vert_collider, &mut ears_queue, polygon, epsilon);
             let ear_right = polygon[v].right(polygon).ptr2index(polygon_range);
-            Self::process_ear(ear_right, &vert_collider, &mut ears_queue, polygon, epsilon);
+            Self::process_ear(ear_right, vert_collider, &mut ears_queue, polygon, epsilon);
             // This is a backup vert that is used if the queue is empty (geometrically
             // invalid polygon), to ensure manifoldness.
             v = ear_right;
@@ -688,6 +752,85 @@ struct IdxCollider {
     itr: Vec<usize>,
 }
 
+///Replaces the C++ multiset of ears: a binary min-heap of ears by ascending
+///cost, where each queued Vert stores its heap position in queue_idx so it can
+///be removed when its cost changes. Equal costs pop in insertion order, as
+///they did from the multiset.
+struct EarQueue {
+    heap: Vec<(OrderedF64, u64, usize)>,
+    next_seq: u64,
+}
+
+impl EarQueue {
+    fn new() -> Self {
+        Self {
+            heap: Vec::new(),
+            next_seq: 0,
+        }
+    }
+
+    fn push(&mut self, v: usize, polygon: &mut [Vert]) {
+        self.heap.push((OrderedF64(polygon[v].cost), self.next_seq, v));
+        self.next_seq += 1;
+        self.sift_up(self.heap.len() - 1, polygon);
+    }
+
+    fn pop(&mut self, polygon: &mut [Vert]) -> Option<usize> {
+        let v = self.heap.first()?.2;
+        self.remove(v, polygon);
+        Some(v)
+    }
+
+    fn remove(&mut self, v: usize, polygon: &mut [Vert]) {
+        let idx = polygon[v].queue_idx;
+        debug_assert!(self.heap[idx].2 == v, "ear not in queue!");
+        let last = self.heap.pop().unwrap();
+        if idx == self.heap.len() {
+            return;
+        }
+        self.heap[idx] = last;
+        polygon[last.2].queue_idx = idx;
+        self.sift_up(idx, polygon);
+        self.sift_down(polygon[last.2].queue_idx, polygon);
+    }
+
+    fn sift_up(&mut self, mut idx: usize, polygon: &mut [Vert]) {
+        let entry = self.heap[idx];
+        while idx > 0 {
+            let parent = (idx - 1) / 2;
+            if self.heap[parent] <= entry {
+                break;
+            }
+            self.heap[idx] = self.heap[parent];
+            polygon[self.heap[idx].2].queue_idx = idx;
+            idx = parent;
+        }
+        self.heap[idx] = entry;
+        polygon[entry.2].queue_idx = idx;
+    }
+
+    fn sift_down(&mut self, mut idx: usize, polygon: &mut [Vert]) {
+        let entry = self.heap[idx];
+        loop {
+            let mut child = 2 * idx + 1;
+            if child >= self.heap.len() {
+                break;
+            }
+            if child + 1 < self.heap.len() && self.heap[child + 1] < self.heap[child] {
+                child += 1;
+            }
+            if entry <= self.heap[child] {
+                break;
+            }
+            self.heap[idx] = self.heap[child];
+            polygon[self.heap[idx].2].queue_idx = idx;
+            idx = child;
+        }
+        self.heap[idx] = entry;
+        polygon[entry.2].queue_idx = idx;
+    }
+}
+
 /// A vertex in a circular doubly-linked list representing the polygon(s) that 
 /// still need to be triangulated.
 /// 
@@ -709,6 +852,8 @@ struct Vert {
     cost: f64,
     /// Whether this vertex forms an ear (used in triangulation)
     ear: bool,
+    /// Position of this vertex in the EarQueue while ear is set
+    queue_idx: usize,
     /// The 2D position of this vertex
     pos: Point2<f64>,
     /// The direction vector to the right neighbor
@@ -1010,6 +1155,20 @@ fn triangulate_convex(polys: &PolygonsIdx) -> Vec<Vector3<i32>> {
     triangles
 }
 
+///The algorithm used by triangulate_idx() for input that is not convex, or
+///when the convex fast path is disallowed.
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub enum Triangulator {
+    ///Monotone partition above K_MONOTONE_MIN_VERTS vertices, ear-clipping
+    ///otherwise.
+    #[default]
+    Auto,
+    ///Always ear-clip. Gives the best triangle quality.
+    EarClip,
+    ///Always try monotone partition first. Input it rejects is ear-clipped.
+    Monotone,
+}
+
 ///@brief Triangulates a set of &epsilon;-valid polygons. If the input is not
 ///&epsilon;-valid, the triangulation may overlap, but will always return a
 ///manifold result that matches the input edge directions.
@@ -1026,12 +1185,110 @@ fn triangulate_convex(polys: &PolygonsIdx) -> Vec<Vector3<i32>> {
 ///@return std::vector<ivec3> The triangles, referencing the original
 ///vertex indicies.
 pub fn triangulate_idx(polys: &PolygonsIdx, epsilon: f64, allow_convex: bool) -> Vec<Vector3<i32>> {
+    triangulate_idx_with(polys, epsilon, allow_convex, Triangulator::Auto)
+}
+
+///triangulate_idx() with an explicit choice of algorithm.
+pub fn triangulate_idx_with(
+    polys: &PolygonsIdx,
+    epsilon: f64,
+    allow_convex: bool,
+    triangulator: Triangulator,
+) -> Vec<Vector3<i32>> {
     if allow_convex && is_convex(polys, epsilon)
     //fast path
     {
-        triangulate_convex(polys)
-    } else {
-        let triangulator = EarClip::new(polys, epsilon);
-        triangulator.triangulate()
+        return triangulate_convex(polys);
     }
-}
\ No newline at end of file
+
+    let monotone = match triangulator {
+        Triangulator::Auto => {
+            polys.iter().map(|poly| poly.len()).sum::<usize>() > K_MONOTONE_MIN_VERTS
+        }
+        Triangulator::EarClip => false,
+        Triangulator::Monotone => true,
+    };
+    if monotone {
+        if let Some(triangles) = triangulate_monotone(polys, epsilon) {
+            return triangles;
+        }
+    }
+    let triangulator = EarClip::new(polys, epsilon);
+    triangulator.triangulate()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn vert(cost: f64) -> Vert {
+        Vert {
+            mesh_idx: 0,
+            cost,
+            ear: false,
+            queue_idx: 0,
+            pos: Point2::new(0.0, 0.0),
+            right_dir: Vector2::new(0.0, 0.0),
+            left_idx: 0,
+            right_idx: 0,
+            self_idx: 0,
+        }
+    }
+
+    #[test]
+    fn ear_queue_matches_multiset_order() {
+        let costs = [3.0, -1.0, 2.0, -1.0, K_BEST, 2.0, 0.5, -1.0, 7.0, 0.5];
+        let mut polygon: Vec<Vert> = costs.iter().map(|&cost| vert(cost)).collect();
+        let mut queue = EarQueue::new();
+        for v in 0..polygon.len() {
+            queue.push(v, &mut polygon);
+        }
+        // Update two ears, as process_ear() does.
+        queue.remove(2, &mut polygon);
+        queue.remove(4, &mut polygon);
+        polygon[2].cost = -1.0;
+        queue.push(2, &mut polygon);
+
+        let mut order = Vec::new();
+        while let Some(v) = queue.pop(&mut polygon) {
+            order.push(v);
+        }
+        assert_eq!(order, vec![1, 3, 7, 2, 6, 9, 5, 0, 8]);
+    }
+
+    #[test]
+    fn triangulates_large_star() {
+        let n = 4000;
+        let poly: SimplePolygonIdx = (0..n)
+            .map(|i| {
+                let angle = 2.0 * std::f64::consts::PI * i as f64 / n as f64;
+                let radius = if i % 2 == 0 { 1.0 } else { 0.9 };
+                PolyVert {
+                    pos: Point2::new(radius * angle.cos(), radius * angle.sin()),
+                    idx: i as i32,
+                }
+            })
+            .collect();
+        let area: f64 = (0..n)
+            .map(|i| {
+                let (a, b) = (poly[i].pos, poly[(i + 1) % n].pos);
+                0.5 * (a.x * b.y - a.y * b.x)
+            })
+            .sum();
+
+        let polys = vec![poly];
+        let tris = triangulate_idx(&polys, 1e-12, false);
+        let poly = &polys[0];
+        assert_eq!(tris.len(), n - 2);
+        let tri_area: f64 = tris
+            .iter()
+            .map(|tri| {
+                let a = poly[tri[0] as usize].pos;
+                let b = poly[tri[1] as usize].pos;
+                let c = poly[tri[2] as usize].pos;
+                0.5 * (b - a).perp(&(c - a))
+            })
+            .sum();
+        assert!((tri_area - area).abs() < 1e-9);
+    }
+}
@@ -0,0 +1,330 @@
+use crate::ManifoldError;
+use crate::collider::Collider;
+use crate::common::Aabb;
+use crate::meshboolimpl::{MESH_ID_COUNTER, MeshBoolImpl, MeshRelationD, Relation};
+use crate::shared::{Halfedge, TriRef};
+use nalgebra::{Matrix3x4, Point3, Vector3};
+use std::collections::BTreeMap;
+use std::io::{self, Read, Write};
+use std::sync::atomic::Ordering;
+
+///Snapshot layout, all little-endian:
+///
+///- the magic bytes, then the format version as a u32 and four reserved bytes;
+///- num_prop, status and originalID as i32s, then four reserved bytes;
+///- epsilon, tolerance and the bounding box (min, max) as f64s;
+///- the length of each array below as a u64;
+///- the arrays, each padded to a multiple of 8 bytes: vert_pos, halfedge,
+///  properties, vert_normal, face_normal, tri_ref, the meshID to Relation
+///  entries, and the collider's node boxes, node parents and internal
+///  children.
+///
+///Every array holds exactly what the impl holds, so loading only decodes the
+///elements, with no sorting or recomputation.
+const MAGIC: &[u8; 8] = b"MBOOLSNP";
+const VERSION: u32 = 1;
+const NUM_ARRAY: usize = 9;
+
+///Elements converted per block, bounding the staging buffer.
+const BLOCK: usize = 1 << 12;
+
+///The stored code of each status. The match is exhaustive so that a new
+///variant has to be given a code here.
+fn status_code(status: ManifoldError) -> i32 {
+    match status {
+        ManifoldError::NoError => 0,
+        ManifoldError::NonFiniteVertex => 1,
+        ManifoldError::NotManifold => 2,
+        ManifoldError::VertexOutOfBounds => 3,
+        ManifoldError::MissingPositionProperties => 4,
+        ManifoldError::MergeVectorsDifferentLengths => 5,
+        ManifoldError::MergeIndexOutOfBounds => 6,
+        ManifoldError::TransformWrongLength => 7,
+        ManifoldError::RunIndexWrongLength => 8,
+        ManifoldError::FaceIdWrongLength => 9,
+        ManifoldError::InvalidConstruction => 10,
+        ManifoldError::ResultTooLarge => 11,
+    }
+}
+
+fn status_from_code(code: i32) -> Option<ManifoldError> {
+    Some(match code {
+        0 => ManifoldError::NoError,
+        1 => ManifoldError::NonFiniteVertex,
+        2 => ManifoldError::NotManifold,
+        3 => ManifoldError::VertexOutOfBounds,
+        4 => ManifoldError::MissingPositionProperties,
+        5 => ManifoldError::MergeVectorsDifferentLengths,
+        6 => ManifoldError::MergeIndexOutOfBounds,
+        7 => ManifoldError::TransformWrongLength,
+        8 => ManifoldError::RunIndexWrongLength,
+        9 => ManifoldError::FaceIdWrongLength,
+        10 => ManifoldError::InvalidConstruction,
+        11 => ManifoldError::ResultTooLarge,
+        _ => return None,
+    })
+}
+
+fn invalid(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, format!("invalid snapshot: {msg}"))
+}
+
+fn f64_at(bytes: &[u8], i: usize) -> f64 {
+    f64::from_le_bytes(bytes[8 * i..8 * i + 8].try_into().unwrap())
+}
+
+fn i32_at(bytes: &[u8], i: usize) -> i32 {
+    i32::from_le_bytes(bytes[4 * i..4 * i + 4].try_into().unwrap())
+}
+
+fn point_at(bytes: &[u8], i: usize) -> Point3<f64> {
+    Point3::new(f64_at(bytes, i), f64_at(bytes, i + 1), f64_at(bytes, i + 2))
+}
+
+fn padding(num_bytes: usize) -> usize {
+    num_bytes.wrapping_neg() % 8
+}
+
+///Writes items of size bytes each through a bounded staging buffer.
+fn write_array<W: Write, T>(
+    writer: &mut W,
+    items: &[T],
+    size: usize,
+    encode: impl Fn(&T, &mut Vec<u8>),
+) -> io::Result<()> {
+    let mut buffer = Vec::with_capacity(size * BLOCK.min(items.len()));
+    for block in items.chunks(BLOCK) {
+        buffer.clear();
+        for item in block {
+            encode(item, &mut buffer);
+        }
+        debug_assert_eq!(buffer.len(), size * block.len());
+        writer.write_all(&buffer)?;
+    }
+    writer.write_all(&[0; 8][..padding(size * items.len())])
+}
+
+///Reads count items of size bytes each. The vector only grows as data
+///arrives, so a corrupt count cannot cause a huge allocation.
+fn read_array<R: Read, T>(
+    reader: &mut R,
+    count: u64,
+    size: usize,
+    decode: impl Fn(&[u8]) -> T,
+) -> io::Result<Vec<T>> {
+    let count = usize::try_from(count).map_err(|_| invalid("array too long"))?;
+    let mut items = Vec::with_capacity(count.min(BLOCK));
+    let mut buffer = vec![0; size * BLOCK.min(count)];
+    while items.len() < count {
+        let num = (count - items.len()).min(BLOCK);
+        let bytes = &mut buffer[..size * num];
+        reader.read_exact(bytes)?;
+        items.extend(bytes.chunks_exact(size).map(&decode));
+    }
+    let pad = padding(size.checked_mul(count).ok_or_else(|| invalid("array too long"))?);
+    reader.read_exact(&mut [0; 8][..pad])?;
+    Ok(items)
+}
+
+fn encode_point(p: &Point3<f64>, out: &mut Vec<u8>) {
+    for x in p.iter() {
+        out.extend_from_slice(&x.to_le_bytes());
+    }
+}
+
+fn encode_vector(v: &Vector3<f64>, out: &mut Vec<u8>) {
+    encode_point(&Point3::from(*v), out);
+}
+
+fn encode_i32s(values: &[i32], out: &mut Vec<u8>) {
+    for x in values {
+        out.extend_from_slice(&x.to_le_bytes());
+    }
+}
+
+impl MeshBoolImpl {
+    pub(crate) fn write_snapshot<W: Write>(&self, writer: &mut W) -> io::Result<()> {
+        let relation = &self.mesh_relation;
+        let status = status_code(self.status);
+        let (node_bbox, node_parent, internal_children) = self.collider.parts();
+
+        let mut header = Vec::with_capacity(168);
+        header.extend_from_slice(MAGIC);
+        header.extend_from_slice(&VERSION.to_le_bytes());
+        encode_i32s(&[0, self.num_prop, status, relation.original_id, 0], &mut header);
+        for x in [self.epsilon, self.tolerance] {
+            header.extend_from_slice(&x.to_le_bytes());
+        }
+        encode_point(&self.bbox.min, &mut header);
+        encode_point(&self.bbox.max, &mut header);
+        let lengths: [usize; NUM_ARRAY] = [
+            self.vert_pos.len(),
+            self.halfedge.len(),
+            self.properties.len(),
+            self.vert_normal.len(),
+            self.face_normal.len(),
+            relation.tri_ref.len(),
+            relation.mesh_id_transform.len(),
+            node_bbox.len(),
+            internal_children.len(),
+        ];
+        for len in lengths {
+            header.extend_from_slice(&(len as u64).to_le_bytes());
+        }
+        writer.write_all(&header)?;
+
+        write_array(writer, &self.vert_pos, 24, encode_point)?;
+        write_array(writer, &self.halfedge, 16, |h, out| {
+            encode_i32s(&[h.start_vert, h.end_vert, h.paired_halfedge, h.prop_vert], out)
+        })?;
+        write_array(writer, &self.properties, 8, |x, out| {
+            out.extend_from_slice(&x.to_le_bytes())
+        })?;
+        write_array(writer, &self.vert_normal, 24, encode_vector)?;
+        write_array(writer, &self.face_normal, 24, encode_vector)?;
+        write_array(writer, &relation.tri_ref, 16, |r, out| {
+            encode_i32s(&[r.mesh_id, r.original_id, r.face_id, r.coplanar_id], out)
+        })?;
+        let relations: Vec<_> = relation.mesh_id_transform.iter().collect();
+        write_array(writer, &relations, 112, |(mesh_id, rel), out| {
+            encode_i32s(&[**mesh_id, rel.original_id, rel.back_side as i32, 0], out);
+            for x in rel.transform.iter() {
+                out.extend_from_slice(&x.to_le_bytes());
+            }
+        })?;
+        write_array(writer, node_bbox, 48, |b, out| {
+            encode_point(&b.min, out);
+            encode_point(&b.max, out);
+        })?;
+        write_array(writer, node_parent, 4, |x, out| encode_i32s(&[*x], out))?;
+        write_array(writer, internal_children, 8, |c, out| encode_i32s(&[c.0, c.1], out))
+    }
+
+    pub(crate) fn read_snapshot<R: Read>(reader: &mut R) -> io::Result<MeshBoolImpl> {
+        let mut header = [0; 16 + 16 + 64 + 8 * NUM_ARRAY];
+        reader.read_exact(&mut header)?;
+        if &header[..8] != MAGIC {
+            return Err(invalid("not a snapshot"));
+        }
+        let version = u32::from_le_bytes(header[8..12].try_into().unwrap());
+        if version != VERSION {
+            return Err(invalid(&format!("unsupported version {version}")));
+        }
+        let num_prop = i32_at(&header, 4);
+        let status =
+            status_from_code(i32_at(&header, 5)).ok_or_else(|| invalid("unknown status"))?;
+        let original_id = i32_at(&header, 6);
+        let epsilon = f64_at(&header, 4);
+        let tolerance = f64_at(&header, 5);
+        let bbox = Aabb {
+            min: point_at(&header, 6),
+            max: point_at(&header, 9),
+        };
+        let len = |i: usize| {
+            u64::from_le_bytes(header[96 + 8 * i..104 + 8 * i].try_into().unwrap())
+        };
+
+        let vert_pos = read_array(reader, len(0), 24, |b| point_at(b, 0))?;
+        let halfedge = read_array(reader, len(1), 16, |b| Halfedge {
+            start_vert: i32_at(b, 0),
+            end_vert: i32_at(b, 1),
+            paired_halfedge: i32_at(b, 2),
+            prop_vert: i32_at(b, 3),
+        })?;
+        let properties = read_array(reader, len(2), 8, |b| f64_at(b, 0))?;
+        let vert_normal = read_array(reader, len(3), 24, |b| point_at(b, 0).coords)?;
+        let face_normal = read_array(reader, len(4), 24, |b| point_at(b, 0).coords)?;
+        let tri_ref = read_array(reader, len(5), 16, |b| TriRef {
+            mesh_id: i32_at(b, 0),
+            original_id: i32_at(b, 1),
+            face_id: i32_at(b, 2),
+            coplanar_id: i32_at(b, 3),
+        })?;
+        let relations = read_array(reader, len(6), 112, |b| {
+            let rel = Relation {
+                original_id: i32_at(b, 1),
+                transform: Matrix3x4::from_fn(|row, col| f64_at(b, 2 + 3 * col + row)),
+                back_side: i32_at(b, 2) != 0,
+            };
+            (i32_at(b, 0), rel)
+        })?;
+        let node_bbox = read_array(reader, len(7), 48, |b| Aabb {
+            min: point_at(b, 0),
+            max: point_at(b, 3),
+        })?;
+        let node_parent = read_array(reader, len(7), 4, |b| i32_at(b, 0))?;
+        let internal_children = read_array(reader, len(8), 8, |b| (i32_at(b, 0), i32_at(b, 1)))?;
+
+        let num_vert = vert_pos.len();
+        let num_tri = tri_ref.len();
+        let num_prop_vert = if num_prop > 0 {
+            properties.len() / num_prop as usize
+        } else {
+            num_vert
+        };
+        if num_prop < 0 || (num_prop > 0 && properties.len() % num_prop as usize != 0) {
+            return Err(invalid("properties do not match num_prop"));
+        }
+        if halfedge.len() != 3 * num_tri
+            || face_normal.len() != num_tri
+            || vert_normal.len() != num_vert
+        {
+            return Err(invalid("array lengths do not match"));
+        }
+        let in_range = |i: i32, len: usize| i >= 0 && (i as usize) < len;
+        if !halfedge.iter().all(|h| {
+            in_range(h.start_vert, num_vert)
+                && in_range(h.end_vert, num_vert)
+                && in_range(h.paired_halfedge, halfedge.len())
+                && in_range(h.prop_vert, num_prop_vert)
+        }) {
+            return Err(invalid("halfedge index out of bounds"));
+        }
+        let num_node = node_bbox.len();
+        let is_tree = if num_node == 0 {
+            internal_children.is_empty()
+        } else {
+            num_node == 2 * internal_children.len() + 1 && (num_node + 1) / 2 == num_tri
+        };
+        if !is_tree
+            || !node_parent.iter().all(|&p| p == -1 || in_range(p, num_node))
+            || !internal_children
+                .iter()
+                .all(|c| in_range(c.0, num_node) && in_range(c.1, num_node))
+        {
+            return Err(invalid("collider does not match the triangles"));
+        }
+
+        // Mesh IDs are unique only within a process, so make sure that new ones
+        // cannot collide with those loaded.
+        let max_id = tri_ref
+            .iter()
+            .flat_map(|r| [r.mesh_id, r.original_id])
+            .chain(relations.iter().flat_map(|(id, rel)| [*id, rel.original_id]))
+            .chain([original_id])
+            .max()
+            .unwrap();
+        if max_id >= 0 {
+            MESH_ID_COUNTER.fetch_max(max_id as usize + 1, Ordering::Relaxed);
+        }
+
+        Ok(MeshBoolImpl {
+            bbox,
+            epsilon,
+            tolerance,
+            num_prop,
+            status,
+            vert_pos,
+            halfedge,
+            properties,
+            vert_normal,
+            face_normal,
+            mesh_relation: MeshRelationD {
+                original_id,
+                mesh_id_transform: relations.into_iter().collect::<BTreeMap<_, _>>(),
+                tri_ref,
+            },
+            collider: Collider::from_parts(node_bbox, node_parent, internal_children),
+        })
+    }
+}
@@ -20,6 +20,38 @@ fn morton_code(position: Point3<f64>, bbox: Aabb) -> u32 {
     }
 }
 
+///Returns the permutation that stably sorts keys, and whether it is the
+///identity. Only the elements after the longest already-sorted prefix are
+///sorted, and are then merged into that prefix, so a sorted array with k
+///appended elements costs O(n + k log k) rather than a full sort.
+fn sorted_new2old(keys: &[u32]) -> (Vec<i32>, bool) {
+    let n = keys.len();
+    let prefix = 1 + keys.windows(2).take_while(|w| w[0] <= w[1]).count();
+    if prefix >= n {
+        return ((0..n as i32).collect(), true);
+    }
+
+    let mut tail: Vec<i32> = (prefix as i32..n as i32).collect();
+    tail.sort_by_key(|&i| keys[i as usize]);
+
+    // Ties go to the prefix, which keeps the result identical to a stable sort.
+    let mut new2old = Vec::with_capacity(n);
+    let mut i = 0;
+    let mut j = 0;
+    while i < prefix && j < tail.len() {
+        if keys[tail[j] as usize] < keys[i] {
+            new2old.push(tail[j]);
+            j += 1;
+        } else {
+            new2old.push(i as i32);
+            i += 1;
+        }
+    }
+    new2old.extend(i as i32..prefix as i32);
+    new2old.extend_from_slice(&tail[j..]);
+    (new2old, false)
+}
+
 impl MeshBoolImpl {
     ///Once halfedge_ has been filled in, this function can be called to create the
     ///rest of the internal data structures. This function also removes the verts
@@ -41,7 +73,7 @@ impl MeshBoolImpl {
         let mut face_box: Vec<Aabb> = Vec::default();
         let mut face_morton: Vec<u32> = Vec::default();
         self.get_face_box_morton(&mut face_box, &mut face_morton);
-        self.sort_faces(&mut face_box, &mut face_morton);
+        let faces_unchanged = self.sort_faces(&mut face_box, &mut face_morton);
         if self.halfedge.len() == 0 {
             return;
         }
@@ -64,7 +96,13 @@ impl MeshBoolImpl {
         );
 
         self.calculate_normals();
-        self.collider = Collider::new(&face_box, &face_morton);
+        // With the same leaves in the same order, the existing radix tree stays
+        // valid and only its boxes need refitting.
+        if faces_unchanged && self.collider.num_leaves() == face_box.len() {
+            self.collider.update_boxes(&face_box);
+        } else {
+            self.collider = Collider::new(&face_box, &face_morton);
+        }
     }
 
     ///Sorts the vertices according to their Morton code.
@@ -75,16 +113,30 @@ impl MeshBoolImpl {
             vert_morton[vert] = morton_code(self.vert_pos[vert], self.bbox);
         }
 
-        let mut vert_new2old: Vec<_> = (0..num_vert as i32).collect();
-        vert_new2old.sort_by_key(|&i| vert_morton[i as usize]);
-
-        self.reindex_verts(&vert_new2old, num_vert);
+        let (mut vert_new2old, in_order) = sorted_new2old(&vert_morton);
 
         // Verts were flagged for removal with NaNs and assigned kNoCode to sort
         // them to the end, which allows them to be removed.
         let new_num_vert =
             vert_new2old.partition_point(|&vert| vert_morton[vert as usize] < K_NO_CODE);
 
+        if in_order {
+            // Already sorted: the removed verts are all at the end and the kept
+            // indices are unchanged, so only truncation is needed.
+            if self.num_prop() == 0 {
+                for edge in &mut self.halfedge {
+                    edge.prop_vert = edge.start_vert;
+                }
+            }
+            vec_resize(&mut self.vert_pos, new_num_vert);
+            if self.vert_normal.len() == num_vert {
+                vec_resize(&mut self.vert_normal, new_num_vert);
+            }
+            return;
+        }
+
+        self.reindex_verts(&vert_new2old, num_vert);
+
         vec_resize(&mut vert_new2old, new_num_vert);
         permute(&mut self.vert_pos, &vert_new2old);
 
@@ -126,7 +178,7 @@ impl MeshBoolImpl {
         }
 
         let mut prop_old2new = vec![0_i32; num_verts + 1];
-        inclusive_scan(keep.iter().cloned(), &mut prop_old2new);
+        inclusive_scan(keep.iter().cloned(), &mut prop_old2new[1..]);
 
         let old_prop = self.properties.clone();
         let num_verts_new = prop_old2new[num_verts];
@@ -181,21 +233,26 @@ impl MeshBoolImpl {
     }
 
     ///Sorts the faces of this manifold according to their input Morton code. The
-    ///bounding box and Morton code arrays are also sorted accordingly.
-    fn sort_faces(&mut self, face_box: &mut Vec<Aabb>, face_morton: &mut Vec<u32>) {
-        let mut face_new2old: Vec<_> = (0..self.num_tri() as i32).collect();
-        face_new2old.sort_by_key(|&i| face_morton[i as usize]);
+    ///bounding box and Morton code arrays are also sorted accordingly. Returns
+    ///true if the faces were already in order and none were removed.
+    fn sort_faces(&mut self, face_box: &mut Vec<Aabb>, face_morton: &mut Vec<u32>) -> bool {
+        let (mut face_new2old, in_order) = sorted_new2old(face_morton);
 
         // Tris were flagged for removal with pairedHalfedge = -1 and assigned kNoCode
         // to sort them to the end, which allows them to be removed.
         let new_num_tri =
             face_new2old.partition_point(|&face| face_morton[face as usize] < K_NO_CODE);
 
+        if in_order && new_num_tri == self.num_tri() {
+            return true;
+        }
+
         vec_resize(&mut face_new2old, new_num_tri);
 
         permute(face_morton, &face_new2old);
         permute(face_box, &face_new2old);
         self.gather_faces(&face_new2old);
+        false
     }
 
     ///Creates the halfedge_ vector for this manifold by copying a set of faces from
@@ -0,0 +1,149 @@
+use crate::meshboolimpl::MeshBoolImpl;
+use crate::{MeshGLP, Precision};
+use std::io::{self, BufRead, BufReader, Read, Write};
+
+const HEADER: usize = 80;
+const FACET: usize = 50;
+
+///Triangles converted per block, bounding the staging buffer.
+const BLOCK: usize = 1 << 12;
+
+fn invalid(msg: &str) -> io::Error {
+    io::Error::new(io::ErrorKind::InvalidData, format!("invalid STL: {msg}"))
+}
+
+///Builds a Manifold from a triangle soup of three corners per triangle. The
+///corners are welded first where their positions are exactly equal, which is
+///nearly always the case for STL, then along any open edges within
+///tolerance, as by MeshGL::merge().
+fn from_corners<P: Precision>(corners: &[[P; 3]]) -> MeshBoolImpl {
+    // Adding zero turns -0 into 0, so they weld.
+    let mut order: Vec<([u64; 3], u32)> = corners
+        .iter()
+        .enumerate()
+        .map(|(i, corner)| (corner.map(|x| (x.to_f64() + 0.0).to_bits()), i as u32))
+        .collect();
+    order.sort_unstable();
+
+    let mut mesh_gl = MeshGLP::<P, u32> {
+        num_prop: 3,
+        tri_verts: vec![0; corners.len()],
+        ..Default::default()
+    };
+    for (i, &(key, corner)) in order.iter().enumerate() {
+        if i == 0 || key != order[i - 1].0 {
+            mesh_gl.vert_properties.extend_from_slice(&corners[corner as usize]);
+        }
+        mesh_gl.tri_verts[corner as usize] = mesh_gl.vert_properties.len() as u32 / 3 - 1;
+    }
+    drop(order);
+
+    mesh_gl.merge();
+    MeshBoolImpl::from_mesh_gl(&mesh_gl)
+}
+
+fn read_binary<R: Read>(reader: &mut R, num_tri: usize) -> io::Result<MeshBoolImpl> {
+    // The count comes from the file, so grow only as triangles arrive.
+    let mut corners: Vec<[f32; 3]> = Vec::with_capacity(3 * num_tri.min(BLOCK));
+    let mut buffer = vec![0; FACET * BLOCK.min(num_tri)];
+    let mut remaining = num_tri;
+    while remaining > 0 {
+        let num = remaining.min(BLOCK);
+        let bytes = &mut buffer[..FACET * num];
+        reader.read_exact(bytes)?;
+        for facet in bytes.chunks_exact(FACET) {
+            // Skip the normal, which is recomputed, and the attribute bytes.
+            for corner in facet[12..48].chunks_exact(12) {
+                corners.push([0, 4, 8].map(|i| {
+                    f32::from_le_bytes(corner[i..i + 4].try_into().unwrap())
+                }));
+            }
+        }
+        remaining -= num;
+    }
+    Ok(from_corners(&corners))
+}
+
+fn read_ascii<R: BufRead>(reader: &mut R) -> io::Result<MeshBoolImpl> {
+    let mut corners: Vec<[f64; 3]> = Vec::new();
+    let mut facet_start = None;
+    let mut line = String::new();
+    while reader.read_line(&mut line)? > 0 {
+        let mut tokens = line.split_ascii_whitespace();
+        match tokens.next() {
+            Some("facet") => facet_start = Some(corners.len()),
+            Some("vertex") => {
+                let mut corner = [0.0; 3];
+                for x in &mut corner {
+                    *x = tokens
+                        .next()
+                        .and_then(|token| token.parse().ok())
+                        .ok_or_else(|| invalid(&format!("bad vertex: {}", line.trim())))?;
+                }
+                corners.push(corner);
+            }
+            Some("endfacet") => {
+                if facet_start.take().map(|start| corners.len() - start) != Some(3) {
+                    return Err(invalid("facets must have three vertices"));
+                }
+            }
+            _ => {}
+        }
+        line.clear();
+    }
+    if facet_start.is_some() {
+        return Err(invalid("unterminated facet"));
+    }
+    Ok(from_corners(&corners))
+}
+
+impl MeshBoolImpl {
+    pub(crate) fn read_stl<R: Read>(reader: R) -> io::Result<MeshBoolImpl> {
+        let mut reader = BufReader::with_capacity(1 << 16, reader);
+        let mut header = [0; HEADER + 4];
+        let prefix = reader.fill_buf()?;
+        let is_ascii = prefix.starts_with(b"solid") && {
+            // Binary headers may also begin with "solid", but are not followed
+            // by a facet on the next line.
+            let text = prefix.splitn(2, |&b| b == b'\n').nth(1).unwrap_or(&[]);
+            let text = text.trim_ascii_start();
+            text.starts_with(b"facet") || text.starts_with(b"endsolid")
+        };
+        if is_ascii {
+            return read_ascii(&mut reader);
+        }
+        reader.read_exact(&mut header)?;
+        let num_tri = u32::from_le_bytes(header[HEADER..].try_into().unwrap());
+        read_binary(&mut reader, num_tri as usize)
+    }
+
+    pub(crate) fn write_stl<W: Write>(&self, writer: &mut W) -> io::Result<()> {
+        let num_tri = u32::try_from(self.num_tri())
+            .map_err(|_| io::Error::new(io::ErrorKind::InvalidInput, "too many triangles"))?;
+        let mut header = [b' '; HEADER];
+        let title = b"binary STL from meshbool";
+        header[..title.len()].copy_from_slice(title);
+        writer.write_all(&header)?;
+        writer.write_all(&num_tri.to_le_bytes())?;
+
+        let mut buffer = Vec::with_capacity(FACET * BLOCK.min(self.num_tri()));
+        for block in (0..self.num_tri()).step_by(BLOCK) {
+            buffer.clear();
+            for tri in block..self.num_tri().min(block + BLOCK) {
+                let normal = self.face_normal.get(tri).copied().unwrap_or_default();
+                for x in normal.iter() {
+                    buffer.extend_from_slice(&(*x as f32).to_le_bytes());
+                }
+                for i in 0..3 {
+                    let vert = self.halfedge[3 * tri + i].start_vert as usize;
+                    for x in self.vert_pos[vert].iter() {
+                        buffer.extend_from_slice(&(*x as f32).to_le_bytes());
+                    }
+                }
+                buffer.extend_from_slice(&[0, 0]);
+            }
+            writer.write_all(&buffer)?;
+        }
+        Ok(())
+    }
+}
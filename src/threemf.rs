@@ -0,0 +1,485 @@
+use crate::MeshGLScratch;
+use crate::meshboolimpl::MeshBoolImpl;
+use crate::utils::{mat3, mat4};
+use nalgebra::{Matrix3x4, Vector3};
+use std::collections::HashMap;
+use std::io::{self, Write};
+
+const MODEL_PATH: &str = "3D/3dmodel.model";
+
+const CONTENT_TYPES: &str = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\
+<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">\
+<Default Extension=\"rels\" \
+ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>\
+<Default Extension=\"model\" \
+ContentType=\"application/vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>\
+</Types>\n";
+
+const RELS: &str = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\
+<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">\
+<Relationship Target=\"/3D/3dmodel.model\" Id=\"rel0\" \
+Type=\"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel\"/>\
+</Relationships>\n";
+
+///Bytes of model XML buffered before they are passed to the zip writer.
+const FLUSH_BYTES: usize = 1 << 16;
+
+const CRC_TABLE: [u32; 256] = crc_table();
+
+const fn crc_table() -> [u32; 256] {
+    let mut table = [0; 256];
+    let mut i = 0;
+    while i < 256 {
+        let mut crc = i as u32;
+        let mut bit = 0;
+        while bit < 8 {
+            crc = if crc & 1 != 0 {
+                0xEDB88320 ^ (crc >> 1)
+            } else {
+                crc >> 1
+            };
+            bit += 1;
+        }
+        table[i] = crc;
+        i += 1;
+    }
+    table
+}
+
+///Continues the CRC-32 of the zip format over bytes, starting from 0.
+fn crc32(crc: u32, bytes: &[u8]) -> u32 {
+    !bytes.iter().fold(!crc, |crc, &b| {
+        CRC_TABLE[((crc ^ b as u32) & 0xFF) as usize] ^ (crc >> 8)
+    })
+}
+
+fn too_large() -> io::Error {
+    io::Error::new(
+        io::ErrorKind::InvalidInput,
+        "3MF exceeds 4 GiB; zip64 is not supported",
+    )
+}
+
+struct ZipEntry {
+    name: &'static str,
+    crc: u32,
+    size: u32,
+    offset: u32,
+}
+
+///A zip writer that needs no seeking and holds no entry in memory: each entry
+///is stored uncompressed, and its CRC and size follow it in a data descriptor.
+struct ZipWriter<'a, W: Write> {
+    inner: &'a mut W,
+    offset: u64,
+    entries: Vec<ZipEntry>,
+    /// The CRC and size of the entry being written.
+    crc: u32,
+    size: u64,
+}
+
+impl<'a, W: Write> ZipWriter<'a, W> {
+    // Stored, with sizes in a data descriptor and UTF-8 names, dated 1980-01-01.
+    const VERSION: u16 = 20;
+    const FLAGS: u16 = 0x0808;
+    const DATE: u16 = (1 << 5) | 1;
+
+    fn new(inner: &'a mut W) -> Self {
+        Self {
+            inner,
+            offset: 0,
+            entries: Vec::new(),
+            crc: 0,
+            size: 0,
+        }
+    }
+
+    fn emit(&mut self, bytes: &[u8]) -> io::Result<()> {
+        self.inner.write_all(bytes)?;
+        self.offset += bytes.len() as u64;
+        Ok(())
+    }
+
+    fn start_entry(&mut self, name: &'static str) -> io::Result<()> {
+        let offset = u32::try_from(self.offset).map_err(|_| too_large())?;
+        let mut header = Vec::with_capacity(30 + name.len());
+        header.extend_from_slice(&0x04034b50u32.to_le_bytes());
+        for field in [Self::VERSION, Self::FLAGS, 0, 0, Self::DATE] {
+            header.extend_from_slice(&field.to_le_bytes());
+        }
+        // The CRC and sizes are left zero for the data descriptor.
+        header.extend_from_slice(&[0; 12]);
+        header.extend_from_slice(&(name.len() as u16).to_le_bytes());
+        header.extend_from_slice(&0u16.to_le_bytes());
+        header.extend_from_slice(name.as_bytes());
+        self.emit(&header)?;
+        self.entries.push(ZipEntry {
+            name,
+            crc: 0,
+            size: 0,
+            offset,
+        });
+        self.crc = 0;
+        self.size = 0;
+        Ok(())
+    }
+
+    fn write_data(&mut self, bytes: &[u8]) -> io::Result<()> {
+        self.crc = crc32(self.crc, bytes);
+        self.size += bytes.len() as u64;
+        self.emit(bytes)
+    }
+
+    fn finish_entry(&mut self) -> io::Result<()> {
+        let size = u32::try_from(self.size).map_err(|_| too_large())?;
+        let entry = self.entries.last_mut().unwrap();
+        entry.crc = self.crc;
+        entry.size = size;
+        let mut descriptor = Vec::with_capacity(16);
+        for field in [0x08074b50, self.crc, size, size] {
+            descriptor.extend_from_slice(&field.to_le_bytes());
+        }
+        self.emit(&descriptor)
+    }
+
+    ///Writes the central directory, which ends the archive.
+    fn finish(mut self) -> io::Result<()> {
+        let start = self.offset;
+        let mut directory = Vec::new();
+        for entry in &self.entries {
+            directory.extend_from_slice(&0x02014b50u32.to_le_bytes());
+            for field in [Self::VERSION, Self::VERSION, Self::FLAGS, 0, 0, Self::DATE] {
+                directory.extend_from_slice(&field.to_le_bytes());
+            }
+            for field in [entry.crc, entry.size, entry.size] {
+                directory.extend_from_slice(&field.to_le_bytes());
+            }
+            // Name, extra and comment lengths, disk, internal attributes.
+            for field in [entry.name.len() as u16, 0, 0, 0, 0] {
+                directory.extend_from_slice(&field.to_le_bytes());
+            }
+            directory.extend_from_slice(&0u32.to_le_bytes());
+            directory.extend_from_slice(&entry.offset.to_le_bytes());
+            directory.extend_from_slice(entry.name.as_bytes());
+        }
+        let start = u32::try_from(start).map_err(|_| too_large())?;
+        let size = directory.len() as u32;
+        let num_entry = self.entries.len() as u16;
+        directory.extend_from_slice(&0x06054b50u32.to_le_bytes());
+        for field in [0, 0, num_entry, num_entry] {
+            directory.extend_from_slice(&field.to_le_bytes());
+        }
+        directory.extend_from_slice(&size.to_le_bytes());
+        directory.extend_from_slice(&start.to_le_bytes());
+        directory.extend_from_slice(&0u16.to_le_bytes());
+        self.emit(&directory)?;
+        self.inner.flush()
+    }
+}
+
+///Passes the buffered XML on once it has grown past FLUSH_BYTES.
+fn flush_full<W: Write>(buffer: &mut Vec<u8>, zip: &mut ZipWriter<'_, W>) -> io::Result<()> {
+    if buffer.len() >= FLUSH_BYTES {
+        zip.write_data(buffer)?;
+        buffer.clear();
+    }
+    Ok(())
+}
+
+///The verts and triangles of a run, keyed so that copies of it can be matched
+///regardless of the order their triangles and verts were left in.
+struct RunShape {
+    /// Each vert by its position, rounded to the grid.
+    verts: HashMap<[i64; 3], u32>,
+    /// Each triangle's verts rotated to put the smallest first, sorted.
+    tris: Vec<[u32; 3]>,
+}
+
+///The inverse of an affine transform, if it is not singular.
+fn invert(transform: &Matrix3x4<f64>) -> Option<Matrix3x4<f64>> {
+    let linear = mat3(transform).try_inverse()?;
+    let mut inverse = Matrix3x4::zeros();
+    inverse.fixed_view_mut::<3, 3>(0, 0).copy_from(&linear);
+    inverse.set_column(3, &-(linear * transform.column(3)));
+    Some(inverse)
+}
+
+fn canonical(tri: [u32; 3]) -> [u32; 3] {
+    let first = (0..3).min_by_key(|&i| tri[i]).unwrap();
+    [tri[first], tri[(first + 1) % 3], tri[(first + 2) % 3]]
+}
+
+///A run written as a component: the mesh object of a prototype run, placed by
+///the transform from the prototype's triangles to its own, if any.
+struct Instance {
+    prototype: usize,
+    transform: Option<Matrix3x4<f64>>,
+}
+
+impl MeshBoolImpl {
+    fn tri_verts(&self, tri: u32) -> [u32; 3] {
+        [0, 1, 2].map(|i| self.halfedge[3 * tri as usize + i].start_vert as u32)
+    }
+
+    fn quantize(&self, pos: Vector3<f64>) -> [i64; 3] {
+        [0, 1, 2].map(|i| (pos[i] / self.epsilon).round() as i64)
+    }
+
+    fn run_shape(&self, tris: &[u32]) -> RunShape {
+        let mut verts = HashMap::new();
+        let mut shape_tris = Vec::with_capacity(tris.len());
+        for &tri in tris {
+            let tri_verts = self.tri_verts(tri);
+            for vert in tri_verts {
+                verts
+                    .entry(self.quantize(self.vert_pos[vert as usize].coords))
+                    .or_insert(vert);
+            }
+            shape_tris.push(canonical(tri_verts));
+        }
+        shape_tris.sort_unstable();
+        RunShape {
+            verts,
+            tris: shape_tris,
+        }
+    }
+
+    ///Returns true if the triangles tris, once mapped by to_shape, are those of
+    ///shape to within epsilon.
+    fn matches_shape(&self, tris: &[u32], to_shape: &Matrix3x4<f64>, shape: &RunShape) -> bool {
+        if tris.len() != shape.tris.len() {
+            return false;
+        }
+        let mut mapped = Vec::with_capacity(tris.len());
+        for &tri in tris {
+            let mut tri_verts = [0; 3];
+            for (i, vert) in self.tri_verts(tri).into_iter().enumerate() {
+                let pos = to_shape * self.vert_pos[vert as usize].to_homogeneous();
+                match shape.verts.get(&self.quantize(pos)) {
+                    Some(&shape_vert) => tri_verts[i] = shape_vert,
+                    None => return false,
+                }
+            }
+            mapped.push(canonical(tri_verts));
+        }
+        mapped.sort_unstable();
+        mapped == shape.tris
+    }
+
+    ///Whether every halfedge of each run pairs with one of the same run, so
+    ///that the run is a closed mesh by itself.
+    fn closed_runs(&self, scratch: &MeshGLScratch) -> Vec<bool> {
+        let mut tri_run = vec![0; self.num_tri()];
+        for run in 0..scratch.num_run() {
+            for &tri in &scratch.tri_new2old[scratch.run_start[run]..scratch.run_start[run + 1]] {
+                tri_run[tri as usize] = run;
+            }
+        }
+        let mut closed = vec![true; scratch.num_run()];
+        for (edge, half) in self.halfedge.iter().enumerate() {
+            let run = tri_run[edge / 3];
+            if half.paired_halfedge < 0 || tri_run[half.paired_halfedge as usize / 3] != run {
+                closed[run] = false;
+            }
+        }
+        closed
+    }
+
+    ///Finds the runs to write as components: each closed run that is a rigid
+    ///copy of the first closed run of the same original it matches, and that
+    ///prototype itself. The rest are None. Only closed runs qualify, since a
+    ///3MF mesh object must be closed; the remaining runs then are too, taken
+    ///together.
+    fn find_instances(&self, scratch: &MeshGLScratch) -> Vec<Option<Instance>> {
+        let run_tris =
+            |run: usize| &scratch.tri_new2old[scratch.run_start[run]..scratch.run_start[run + 1]];
+        let closed = self.closed_runs(scratch);
+        let mut shapes: HashMap<usize, RunShape> = HashMap::new();
+        let mut prototypes: HashMap<i32, Vec<usize>> = HashMap::new();
+        let mut instances = Vec::new();
+        let mut num_copy = vec![0; scratch.num_run()];
+        for run in 0..scratch.num_run() {
+            let rel = &scratch.run_rel[run];
+            if rel.original_id < 0
+                || !(self.epsilon > 0.0)
+                || run_tris(run).is_empty()
+                || !closed[run]
+            {
+                instances.push(None);
+                continue;
+            }
+
+            let mut instance = Instance {
+                prototype: run,
+                transform: None,
+            };
+            let candidates = prototypes.entry(rel.original_id).or_default();
+            for &prototype in candidates.iter() {
+                let Some(inverse) = invert(&scratch.run_rel[prototype].transform) else {
+                    continue;
+                };
+                let transform = rel.transform * mat4(&inverse);
+                let Some(to_prototype) = invert(&transform) else {
+                    continue;
+                };
+                if mat3(&transform).determinant() > 0.0
+                    && self.matches_shape(run_tris(run), &to_prototype, &shapes[&prototype])
+                {
+                    instance = Instance {
+                        prototype,
+                        transform: Some(transform),
+                    };
+                    break;
+                }
+            }
+            if instance.prototype == run {
+                candidates.push(run);
+                shapes.insert(run, self.run_shape(run_tris(run)));
+            }
+            num_copy[instance.prototype] += 1;
+            instances.push(Some(instance));
+        }
+
+        // A prototype without copies gains nothing from being apart.
+        for instance in &mut instances {
+            if instance.as_ref().is_some_and(|i| num_copy[i.prototype] < 2) {
+                *instance = None;
+            }
+        }
+        instances
+    }
+
+    ///Writes the <mesh> of the given runs' triangles, with their verts
+    ///renumbered in order of first use. vert2local must be all u32::MAX, and is
+    ///left that way.
+    fn write_mesh<W: Write>(
+        &self,
+        scratch: &MeshGLScratch,
+        runs: &[usize],
+        vert2local: &mut [u32],
+        buffer: &mut Vec<u8>,
+        zip: &mut ZipWriter<'_, W>,
+    ) -> io::Result<()> {
+        let run_tris = |run: usize| {
+            scratch.tri_new2old[scratch.run_start[run]..scratch.run_start[run + 1]].iter()
+        };
+        writeln!(buffer, "<mesh>\n<vertices>")?;
+        let mut num_local = 0;
+        for &tri in runs.iter().flat_map(|&run| run_tris(run)) {
+            for vert in self.tri_verts(tri) {
+                if vert2local[vert as usize] == u32::MAX {
+                    vert2local[vert as usize] = num_local;
+                    num_local += 1;
+                    let pos = self.vert_pos[vert as usize];
+                    writeln!(
+                        buffer,
+                        "<vertex x=\"{}\" y=\"{}\" z=\"{}\"/>",
+                        pos.x, pos.y, pos.z
+                    )?;
+                }
+            }
+            flush_full(buffer, zip)?;
+        }
+        writeln!(buffer, "</vertices>\n<triangles>")?;
+        for &tri in runs.iter().flat_map(|&run| run_tris(run)) {
+            let [v1, v2, v3] = self.tri_verts(tri).map(|vert| vert2local[vert as usize]);
+            writeln!(buffer, "<triangle v1=\"{v1}\" v2=\"{v2}\" v3=\"{v3}\"/>")?;
+            flush_full(buffer, zip)?;
+        }
+        writeln!(buffer, "</triangles>\n</mesh>")?;
+        for &tri in runs.iter().flat_map(|&run| run_tris(run)) {
+            for vert in self.tri_verts(tri) {
+                vert2local[vert as usize] = u32::MAX;
+            }
+        }
+        Ok(())
+    }
+
+    pub(crate) fn write_3mf<W: Write>(&self, writer: &mut W) -> io::Result<()> {
+        let mut scratch = MeshGLScratch::default();
+        scratch.begin(self, false);
+        let instances = self.find_instances(&scratch);
+
+        let mut zip = ZipWriter::new(writer);
+        zip.start_entry("[Content_Types].xml")?;
+        zip.write_data(CONTENT_TYPES.as_bytes())?;
+        zip.finish_entry()?;
+        zip.start_entry("_rels/.rels")?;
+        zip.write_data(RELS.as_bytes())?;
+        zip.finish_entry()?;
+
+        zip.start_entry(MODEL_PATH)?;
+        let mut buffer: Vec<u8> = Vec::with_capacity(2 * FLUSH_BYTES);
+        write!(
+            buffer,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n\
+             <model unit=\"millimeter\" xml:lang=\"en-US\" \
+             xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\">\n\
+             <resources>\n"
+        )?;
+
+        // Each prototype's mesh object, numbered from 1 in run order, then one
+        // of all the other runs.
+        let mut run_object = vec![0; scratch.num_run()];
+        let mut num_object = 0;
+        let mut vert2local = vec![u32::MAX; self.num_vert()];
+        for (run, instance) in instances.iter().enumerate() {
+            if !instance.as_ref().is_some_and(|i| i.prototype == run) {
+                continue;
+            }
+            num_object += 1;
+            run_object[run] = num_object;
+            let original_id = scratch.run_rel[run].original_id;
+            writeln!(
+                buffer,
+                "<object id=\"{num_object}\" type=\"model\" name=\"original_{original_id}\">"
+            )?;
+            self.write_mesh(&scratch, &[run], &mut vert2local, &mut buffer, &mut zip)?;
+            writeln!(buffer, "</object>")?;
+        }
+        let rest: Vec<usize> = (0..scratch.num_run())
+            .filter(|&run| instances[run].is_none())
+            .filter(|&run| scratch.run_start[run] < scratch.run_start[run + 1])
+            .collect();
+        let mut rest_object = 0;
+        if !rest.is_empty() {
+            num_object += 1;
+            rest_object = num_object;
+            writeln!(buffer, "<object id=\"{num_object}\" type=\"model\">")?;
+            self.write_mesh(&scratch, &rest, &mut vert2local, &mut buffer, &mut zip)?;
+            writeln!(buffer, "</object>")?;
+        }
+
+        // The whole manifold is one object assembled from these, so it stays a
+        // single part on the build plate.
+        if num_object > 0 {
+            writeln!(
+                buffer,
+                "<object id=\"{}\" type=\"model\">\n<components>",
+                num_object + 1
+            )?;
+            for instance in instances.iter().flatten() {
+                let object = run_object[instance.prototype];
+                write!(buffer, "<component objectid=\"{object}\"")?;
+                if let Some(transform) = &instance.transform {
+                    // 3MF row vectors make this the column-major 3x4.
+                    let values: Vec<String> = transform.iter().map(|x| x.to_string()).collect();
+                    write!(buffer, " transform=\"{}\"", values.join(" "))?;
+                }
+                writeln!(buffer, "/>")?;
+            }
+            if rest_object > 0 {
+                writeln!(buffer, "<component objectid=\"{rest_object}\"/>")?;
+            }
+            writeln!(buffer, "</components>\n</object>")?;
+        }
+        writeln!(buffer, "</resources>\n<build>")?;
+        if num_object > 0 {
+            writeln!(buffer, "<item objectid=\"{}\"/>", num_object + 1)?;
+        }
+        writeln!(buffer, "</build>\n</model>")?;
+        zip.write_data(&buffer)?;
+        zip.finish_entry()?;
+        zip.finish()
+    }
+}
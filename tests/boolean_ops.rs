@@ -1,5 +1,8 @@
 use meshbool::{cube, get_mesh_gl};
 
+mod common;
+use common::{assert_closed, volume};
+
 #[test]
 fn test_basic_boolean_operations() {
     use nalgebra::Vector3;
@@ -72,3 +75,31 @@ fn test_cube_intersection() {
 
     assert!(!mesh.tri_verts.is_empty());
 }
+
+#[test]
+fn test_large_difference_simplifies() {
+    use meshbool::cylinder;
+    use nalgebra::Vector3;
+
+    // A fine cylinder drilled through a cube. The result has more than 10k
+    // halfedges, and the sides cut at the faces of the cube leave colinear
+    // verts to remove.
+    let n = 2048;
+    let r = 0.5;
+    let block = cube(Vector3::new(2.0, 2.0, 2.0), true);
+    let drilled = &block - &cylinder(4.0, r, r, n, true);
+    let mesh = get_mesh_gl(&drilled, 0);
+    assert!(3 * drilled.num_tri() > 10_000);
+    assert_closed(&mesh);
+
+    let hole_area = n as f64 / 2.0 * r * r * (2.0 * std::f64::consts::PI / n as f64).sin();
+    assert!((volume(&mesh) - (8.0 - 2.0 * hole_area)).abs() < 1e-4);
+
+    // A bore makes a torus: V - E + F = 2 - 2 * genus.
+    let mut verts = mesh.tri_verts.clone();
+    verts.sort_unstable();
+    verts.dedup();
+    let num_tri = mesh.tri_verts.len() / 3;
+    let euler = verts.len() as i64 - (3 * num_tri / 2) as i64 + num_tri as i64;
+    assert_eq!(euler, 0);
+}
@@ -0,0 +1,57 @@
+use meshbool::{MeshGL, cube, from_mesh_gl, get_mesh_gl};
+use nalgebra::Vector3;
+use std::collections::HashMap;
+
+///The signed volume enclosed by the triangles of a mesh.
+#[allow(dead_code)]
+pub fn volume(mesh: &MeshGL) -> f64 {
+    let num_prop = mesh.num_prop as usize;
+    let pos = |v: u32| {
+        let i = v as usize * num_prop;
+        Vector3::new(
+            mesh.vert_properties[i] as f64,
+            mesh.vert_properties[i + 1] as f64,
+            mesh.vert_properties[i + 2] as f64,
+        )
+    };
+    mesh.tri_verts
+        .chunks(3)
+        .map(|tri| pos(tri[0]).dot(&pos(tri[1]).cross(&pos(tri[2]))) / 6.0)
+        .sum()
+}
+
+///Checks that every directed edge is matched by exactly one reverse edge.
+#[allow(dead_code)]
+pub fn assert_closed(mesh: &MeshGL) {
+    let mut edges: HashMap<(u32, u32), i32> = HashMap::new();
+    for tri in mesh.tri_verts.chunks(3) {
+        for i in 0..3 {
+            *edges.entry((tri[i], tri[(i + 1) % 3])).or_default() += 1;
+        }
+    }
+    for (&(v0, v1), &count) in &edges {
+        assert_eq!(count, 1);
+        assert_eq!(edges.get(&(v1, v0)), Some(&1));
+    }
+}
+
+///A unit cube with a face normal on every corner, so each corner vert is split
+///into three that must be merged.
+#[allow(dead_code)]
+pub fn cube_with_normals() -> meshbool::Impl {
+    let mesh = get_mesh_gl(&cube(Vector3::new(1.0, 1.0, 1.0), false), -1);
+    let mut soup = MeshGL {
+        num_prop: 6,
+        ..Default::default()
+    };
+    for tri in mesh.tri_verts.chunks(3) {
+        let p = |v: u32| Vector3::from_column_slice(&mesh.vert_properties[3 * v as usize..][..3]);
+        let normal = (p(tri[1]) - p(tri[0])).cross(&(p(tri[2]) - p(tri[0]))).normalize();
+        for &v in tri {
+            soup.tri_verts.push(soup.vert_properties.len() as u32 / 6);
+            soup.vert_properties.extend(p(v).iter().chain(normal.iter()));
+        }
+    }
+    assert!(soup.merge());
+    from_mesh_gl(&soup)
+}
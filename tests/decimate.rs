@@ -0,0 +1,74 @@
+use meshbool::{cube, cylinder, decimate, extrude, get_mesh_gl, rotate, translate};
+use nalgebra::{Point2, Point3, Vector3};
+
+mod common;
+use common::{assert_closed, volume};
+
+#[test]
+fn test_decimate_to_target() {
+    let a = cylinder(2.0, 1.0, 1.0, 128, true);
+    let b = rotate(
+        &translate(
+            &cylinder(2.0, 1.0, 1.0, 128, true),
+            Point3::new(0.31, 0.23, 0.17),
+        ),
+        10.0,
+        20.0,
+        30.0,
+    );
+    let union = &a + &b;
+    let before = get_mesh_gl(&union, 0);
+    let decimated = decimate(&union, 500, f64::INFINITY);
+    let after = get_mesh_gl(&decimated, 0);
+
+    assert!(union.num_tri() > 1000);
+    assert!(decimated.num_tri() <= 500);
+    assert!(decimated.num_tri() >= 400);
+    assert_closed(&after);
+    assert!((volume(&after) - volume(&before)).abs() < 0.05 * volume(&before));
+}
+
+#[test]
+fn test_decimate_max_error() {
+    // Every vert of a cylinder lies on a rim, so collapsing any of them moves
+    // the curved side and a tiny max_error leaves it unchanged.
+    let cylinder = cylinder(2.0, 1.0, 1.0, 64, true);
+    let decimated = decimate(&cylinder, 0, 1e-6);
+    let mesh = get_mesh_gl(&decimated, 0);
+    assert_closed(&mesh);
+    assert_eq!(decimated.num_vert(), cylinder.num_vert());
+    assert!((volume(&mesh) - volume(&get_mesh_gl(&cylinder, 0))).abs() < 1e-5);
+
+    let coarse = decimate(&cylinder, 0, 0.1);
+    assert!(coarse.num_tri() < cylinder.num_tri());
+    assert_closed(&get_mesh_gl(&coarse, 0));
+}
+
+#[test]
+fn test_decimate_flat_without_error() {
+    // The verts between the divisions of an extruded square lie on straight
+    // edges of the box, so they collapse without error.
+    let square = vec![vec![
+        Point2::new(0.0, 0.0),
+        Point2::new(1.0, 0.0),
+        Point2::new(1.0, 1.0),
+        Point2::new(0.0, 1.0),
+    ]];
+    let column = extrude(&square, 4.0, 3, 0.0, Point2::new(1.0, 1.0));
+    assert_eq!(column.num_vert(), 20);
+
+    let decimated = decimate(&column, 0, 1e-6);
+    let mesh = get_mesh_gl(&decimated, 0);
+    assert_closed(&mesh);
+    assert_eq!(decimated.num_vert(), 8);
+    assert_eq!(decimated.num_tri(), 12);
+    assert!((volume(&mesh) - volume(&get_mesh_gl(&column, 0))).abs() < 1e-9);
+}
+
+#[test]
+fn test_decimate_keeps_corners() {
+    let cube = cube(Vector3::new(1.0, 1.0, 1.0), true);
+    let decimated = decimate(&cube, 0, 0.01);
+    assert_eq!(decimated.num_tri(), 12);
+    assert_eq!(decimated.num_vert(), 8);
+}
@@ -0,0 +1,113 @@
+use meshbool::{ManifoldError, cube, get_mesh_gl, read_glb, translate, write_glb};
+use nalgebra::{Point3, Vector3};
+use std::io::ErrorKind;
+
+mod common;
+use common::{cube_with_normals, volume};
+
+#[test]
+fn test_glb_round_trip_runs() {
+    let a = cube(Vector3::new(2.0, 2.0, 2.0), true);
+    let b = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), Point3::new(0.5, 0.5, 0.5));
+    let part = &a - &b;
+    let mut bytes = Vec::new();
+    write_glb(&part, -1, &mut bytes).unwrap();
+    assert_eq!(&bytes[..4], b"glTF");
+    assert_eq!(u32::from_le_bytes(bytes[8..12].try_into().unwrap()) as usize, bytes.len());
+
+    let result = read_glb(bytes.as_slice()).unwrap();
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), part.num_vert());
+    assert_eq!(result.num_tri(), part.num_tri());
+    assert_eq!(get_mesh_gl(&result, -1).run_original_id.len(), 2);
+    assert!((volume(&get_mesh_gl(&result, -1)) - 7.875).abs() < 1e-5);
+
+    bytes.truncate(bytes.len() - 4);
+    assert_eq!(read_glb(bytes.as_slice()).unwrap_err().kind(), ErrorKind::InvalidData);
+}
+
+#[test]
+fn test_glb_merge_vectors() {
+    let part = cube_with_normals();
+    assert_eq!(part.num_prop(), 3);
+    let mut bytes = Vec::new();
+    write_glb(&part, 0, &mut bytes).unwrap();
+    let json_len = u32::from_le_bytes(bytes[12..16].try_into().unwrap()) as usize;
+    let json = String::from_utf8(bytes[20..20 + json_len].to_vec()).unwrap();
+    assert!(json.contains("\"NORMAL\""));
+    assert!(json.contains("\"mergeIndices\""));
+
+    let result = read_glb(bytes.as_slice()).unwrap();
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), 8);
+    assert_eq!(result.num_prop(), 3);
+    let (before, after) = (get_mesh_gl(&part, 0), get_mesh_gl(&result, 0));
+    assert_eq!(after.vert_properties, before.vert_properties);
+    assert_eq!(after.merge_from_vert, before.merge_from_vert);
+
+    // Without the extension, the verts are welded by position instead.
+    let renamed = json.replace("EXT_mesh_manifold", "EXT_mesh_ignored_");
+    bytes[20..20 + json_len].copy_from_slice(renamed.as_bytes());
+    let welded = read_glb(bytes.as_slice()).unwrap();
+    assert_eq!(welded.status, ManifoldError::NoError);
+    assert_eq!(welded.num_vert(), 8);
+    assert!((volume(&get_mesh_gl(&welded, -1)) - 1.0).abs() < 1e-6);
+}
+
+///A GLB holding the given JSON and a binary chunk of one triangle.
+fn glb(json: &str) -> Vec<u8> {
+    let mut json = json.as_bytes().to_vec();
+    json.resize(json.len().div_ceil(4) * 4, b' ');
+    let mut bin = Vec::new();
+    for x in [0.0f32, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0] {
+        bin.extend_from_slice(&x.to_le_bytes());
+    }
+    for i in 0u32..3 {
+        bin.extend_from_slice(&i.to_le_bytes());
+    }
+
+    let mut bytes = Vec::new();
+    for word in [0x46546C67, 2, (28 + json.len() + bin.len()) as u32] {
+        bytes.extend_from_slice(&u32::to_le_bytes(word));
+    }
+    bytes.extend_from_slice(&(json.len() as u32).to_le_bytes());
+    bytes.extend_from_slice(&0x4E4F534Au32.to_le_bytes());
+    bytes.extend_from_slice(&json);
+    bytes.extend_from_slice(&(bin.len() as u32).to_le_bytes());
+    bytes.extend_from_slice(&0x004E4942u32.to_le_bytes());
+    bytes.extend_from_slice(&bin);
+    bytes
+}
+
+#[test]
+fn test_glb_rejects_hostile_sizes() {
+    let gltf = |count: &str, stride: &str, offset: &str| {
+        format!(
+            r#"{{"asset":{{"version":"2.0"}},
+            "meshes":[{{"primitives":[{{"attributes":{{"POSITION":0}},"indices":1}}]}}],
+            "accessors":[
+                {{"bufferView":0,"componentType":5126,"count":{count},"type":"VEC3"}},
+                {{"bufferView":1,"componentType":5125,"count":3,"type":"SCALAR"}}],
+            "bufferViews":[
+                {{"buffer":0,"byteLength":36,"byteOffset":{offset}{stride}}},
+                {{"buffer":0,"byteLength":12,"byteOffset":36}}],
+            "buffers":[{{"byteLength":48}}]}}"#
+        )
+    };
+    let read = |json: &str| read_glb(glb(json).as_slice()).map(|r| r.num_tri());
+    // Sizes that overflow or point outside the buffer are errors, not panics.
+    for json in [
+        gltf("1e30", "", "0"),
+        gltf("9007199254740992", "", "0"),
+        gltf("4611686018427387904", "", "0"),
+        gltf("3", "", "18446744073709551615"),
+        gltf("3", "", "9007199254740992"),
+        gltf("3", r#","byteStride":0"#, "0"),
+        gltf("1000000000000", r#","byteStride":12"#, "0"),
+    ] {
+        assert_eq!(read(&json).unwrap_err().kind(), ErrorKind::InvalidData, "{json}");
+    }
+
+    let deep = format!("{}{}", "[".repeat(100_000), "]".repeat(100_000));
+    assert_eq!(read(&deep).unwrap_err().kind(), ErrorKind::InvalidData);
+}
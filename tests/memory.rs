@@ -0,0 +1,47 @@
+use meshbool::{boolean, cube, OpType};
+use nalgebra::Vector3;
+
+#[cfg(feature = "alloc-stats")]
+#[global_allocator]
+static ALLOC: meshbool::alloc_stats::PeakAlloc = meshbool::alloc_stats::PeakAlloc::new();
+
+#[test]
+fn test_memory_footprint() {
+    let empty = meshbool::Impl::default();
+    assert_eq!(empty.memory_footprint().total(), 0);
+
+    let cube = cube(Vector3::new(1.0, 1.0, 1.0), true);
+    let footprint = cube.memory_footprint();
+
+    assert!(footprint.vert_pos >= 8 * 3 * 8);
+    assert!(footprint.halfedge >= 36 * 16);
+    assert!(footprint.face_normal >= 12 * 3 * 8);
+    assert!(footprint.tri_ref > 0);
+    assert!(footprint.mesh_id_transform > 0);
+    assert!(footprint.collider > 0);
+}
+
+#[test]
+fn test_memory_footprint_grows_with_mesh() {
+    let cube1 = cube(Vector3::new(1.0, 1.0, 1.0), true);
+    let cube2 = cube(Vector3::new(1.0, 1.0, 1.0), false);
+    let union = boolean(&cube1, &cube2, OpType::Add);
+
+    assert!(union.memory_footprint().halfedge > cube1.memory_footprint().halfedge);
+}
+
+#[cfg(feature = "alloc-stats")]
+#[test]
+fn test_peak_allocation() {
+    use meshbool::alloc_stats::measure_peak;
+    use meshbool::get_mesh_gl;
+
+    let cube1 = cube(Vector3::new(1.0, 1.0, 1.0), true);
+    let cube2 = cube(Vector3::new(1.0, 1.0, 1.0), false);
+
+    let (union, boolean_peak) = measure_peak(|| boolean(&cube1, &cube2, OpType::Add));
+    assert!(boolean_peak >= union.memory_footprint().total());
+
+    let (mesh, export_peak) = measure_peak(|| get_mesh_gl(&union, 0));
+    assert!(export_peak >= mesh.tri_verts.len() * 4);
+}
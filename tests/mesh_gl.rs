@@ -0,0 +1,349 @@
+use meshbool::{
+    ManifoldError, MeshGL, MeshGL64, MeshGLScratch, cube, from_mesh_gl, get_mesh_gl,
+    get_mesh_gl64, get_mesh_gl_into, mesh_gl_chunks, rotate, translate,
+};
+use nalgebra::{Point3, Vector3};
+use std::collections::HashMap;
+
+mod common;
+use common::{cube_with_normals, volume};
+
+///A unit cube with one property channel holding the face ID, so every corner
+///is split into three verts that are merged back in a chain.
+fn cube_with_face_props() -> MeshGL {
+    let mesh = get_mesh_gl(&cube(Vector3::new(1.0, 1.0, 1.0), false), 0);
+    let mut vert_properties = Vec::new();
+    let mut tri_verts = Vec::new();
+    let mut copies: HashMap<u32, Vec<u32>> = HashMap::new();
+    let mut split: HashMap<(u32, u32), u32> = HashMap::new();
+    for (tri, verts) in mesh.tri_verts.chunks(3).enumerate() {
+        let face = mesh.face_id[tri];
+        for &vert in verts {
+            let idx = *split.entry((vert, face)).or_insert_with(|| {
+                let idx = (vert_properties.len() / 4) as u32;
+                let i = 3 * vert as usize;
+                vert_properties.extend_from_slice(&mesh.vert_properties[i..i + 3]);
+                vert_properties.push(face as f32);
+                copies.entry(vert).or_default().push(idx);
+                idx
+            });
+            tri_verts.push(idx);
+        }
+    }
+
+    let mut merge_from_vert = Vec::new();
+    let mut merge_to_vert = Vec::new();
+    for verts in copies.values() {
+        for pair in verts.windows(2) {
+            merge_from_vert.push(pair[1]);
+            merge_to_vert.push(pair[0]);
+        }
+    }
+
+    MeshGL {
+        num_prop: 4,
+        vert_properties,
+        tri_verts,
+        merge_from_vert,
+        merge_to_vert,
+        run_index: Vec::new(),
+        run_original_id: Vec::new(),
+        run_transform: Vec::new(),
+        face_id: Vec::new(),
+        tolerance: 0.0,
+    }
+}
+
+#[test]
+fn test_mesh_gl_round_trip() {
+    let a = cube(Vector3::new(2.0, 2.0, 2.0), true);
+    let b = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), Point3::new(0.5, 0.5, 0.5));
+    let mesh = get_mesh_gl(&(&a - &b), 0);
+
+    let result = from_mesh_gl(&mesh);
+    assert_eq!(result.status, ManifoldError::NoError);
+    let round_trip = get_mesh_gl(&result, 0);
+    assert_eq!(round_trip.tri_verts.len(), mesh.tri_verts.len());
+    assert_eq!(round_trip.vert_properties.len(), mesh.vert_properties.len());
+    assert_eq!(round_trip.run_original_id, mesh.run_original_id);
+    assert!((volume(&round_trip) - 7.875).abs() < 1e-5);
+}
+
+#[test]
+fn test_mesh_gl_merge_chains_keep_properties() {
+    let mesh = cube_with_face_props();
+    assert_eq!(mesh.vert_properties.len() / 4, 24);
+
+    let result = from_mesh_gl(&mesh);
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), 8);
+    assert_eq!(result.num_tri(), 12);
+    assert_eq!(result.num_prop(), 1);
+
+    let out = get_mesh_gl(&result, -1);
+    assert_eq!(out.num_prop, 4);
+    assert_eq!(out.vert_properties.len() / 4, 24);
+    assert_eq!(out.merge_from_vert.len(), 16);
+    assert!((volume(&out) - 1.0).abs() < 1e-6);
+}
+
+#[test]
+fn test_mesh_gl_invalid_input() {
+    let mut open = cube_with_face_props();
+    open.tri_verts.truncate(33);
+    assert_eq!(from_mesh_gl(&open).status, ManifoldError::NotManifold);
+
+    let mut unmerged = cube_with_face_props();
+    unmerged.merge_from_vert.clear();
+    unmerged.merge_to_vert.clear();
+    assert_eq!(from_mesh_gl(&unmerged).status, ManifoldError::NotManifold);
+
+    let mut out_of_bounds = cube_with_face_props();
+    out_of_bounds.tri_verts[5] = 24;
+    assert_eq!(
+        from_mesh_gl(&out_of_bounds).status,
+        ManifoldError::VertexOutOfBounds
+    );
+
+    let mut lengths = cube_with_face_props();
+    lengths.merge_to_vert.pop();
+    assert_eq!(
+        from_mesh_gl(&lengths).status,
+        ManifoldError::MergeVectorsDifferentLengths
+    );
+
+    let mut face_ids = get_mesh_gl(&cube(Vector3::new(1.0, 1.0, 1.0), false), 0);
+    face_ids.face_id[0] = u32::MAX;
+    assert_eq!(
+        from_mesh_gl(&face_ids).status,
+        ManifoldError::InvalidConstruction
+    );
+}
+
+#[test]
+fn test_mesh_gl_collapses_unnecessary_verts() {
+    // Split the first triangle of a cube at its centroid, leaving a vert that
+    // adds nothing to the shape.
+    let mut mesh = get_mesh_gl(&cube(Vector3::new(1.0, 1.0, 1.0), false), 0);
+    let [a, b, c] = [0, 1, 2].map(|i| mesh.tri_verts[i]);
+    let center = (mesh.vert_properties.len() / 3) as u32;
+    for i in 0..3 {
+        let pos = |vert: u32| mesh.vert_properties[3 * vert as usize + i];
+        let mean = (pos(a) + pos(b) + pos(c)) / 3.0;
+        mesh.vert_properties.push(mean);
+    }
+    mesh.tri_verts[2] = center;
+    mesh.tri_verts.extend_from_slice(&[b, c, center, c, a, center]);
+    let face = mesh.face_id[0];
+    mesh.face_id.extend_from_slice(&[face, face]);
+    mesh.run_index.clear();
+    mesh.run_original_id.clear();
+    mesh.run_transform.clear();
+
+    let result = from_mesh_gl(&mesh);
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), 8);
+    assert_eq!(result.num_tri(), 12);
+    assert!((volume(&get_mesh_gl(&result, 0)) - 1.0).abs() < 1e-6);
+}
+
+///Gives every triangle corner its own vert, as in an STL file.
+fn triangle_soup(mesh: &MeshGL) -> MeshGL {
+    let num_prop = mesh.num_prop as usize;
+    let mut vert_properties = Vec::with_capacity(mesh.tri_verts.len() * num_prop);
+    for &vert in &mesh.tri_verts {
+        let i = vert as usize * num_prop;
+        vert_properties.extend_from_slice(&mesh.vert_properties[i..i + num_prop]);
+    }
+    MeshGL {
+        num_prop: mesh.num_prop,
+        vert_properties,
+        tri_verts: (0..mesh.tri_verts.len() as u32).collect(),
+        merge_from_vert: Vec::new(),
+        merge_to_vert: Vec::new(),
+        run_index: Vec::new(),
+        run_original_id: Vec::new(),
+        run_transform: Vec::new(),
+        face_id: Vec::new(),
+        tolerance: 0.0,
+    }
+}
+
+#[test]
+fn test_mesh_gl_merge_welds_soup() {
+    let a = cube(Vector3::new(2.0, 2.0, 2.0), true);
+    let b = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), Point3::new(0.5, 0.5, 0.5));
+    let mesh = get_mesh_gl(&(&a - &b), 0);
+
+    let mut soup = triangle_soup(&mesh);
+    assert_eq!(from_mesh_gl(&soup).status, ManifoldError::NotManifold);
+    assert!(soup.merge());
+    assert_eq!(
+        soup.merge_from_vert.len(),
+        soup.tri_verts.len() - mesh.vert_properties.len() / 3
+    );
+
+    let result = from_mesh_gl(&soup);
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), mesh.vert_properties.len() / 3);
+    assert!((volume(&get_mesh_gl(&result, 0)) - 7.875).abs() < 1e-5);
+
+    assert!(!soup.merge());
+    let mut closed = get_mesh_gl(&a, 0);
+    assert!(!closed.merge());
+}
+
+#[test]
+fn test_mesh_gl64_keeps_double_precision() {
+    let offset = Point3::new(1.0 / 3.0, 1e8 + 0.25, -2.0 / 7.0);
+    let a = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), offset);
+    let mesh: MeshGL64 = get_mesh_gl64(&a, 0);
+    assert_eq!(mesh.num_prop, 3);
+    for vert in mesh.vert_properties.chunks(3) {
+        for i in 0..3 {
+            let corner = vert[i] - offset[i];
+            assert!(corner == 0.0 || corner == 1.0, "{corner}");
+        }
+    }
+
+    let result = from_mesh_gl(&mesh);
+    assert_eq!(result.status, ManifoldError::NoError);
+    let round_trip = get_mesh_gl64(&result, 0);
+    let mut before = mesh.vert_properties.clone();
+    let mut after = round_trip.vert_properties.clone();
+    before.sort_by(f64::total_cmp);
+    after.sort_by(f64::total_cmp);
+    assert_eq!(before, after);
+
+    // The single-precision output cannot hold the offset.
+    let mesh32 = get_mesh_gl(&a, 0);
+    assert!(mesh32.vert_properties.iter().all(|&x| x as f64 != offset.y));
+}
+
+#[test]
+fn test_mesh_gl_into_reuses_buffers() {
+    let a = from_mesh_gl(&cube_with_face_props());
+    let b = translate(&a, Point3::new(0.5, 0.5, 0.5));
+    let small = &a - &b;
+    let large = &a + &b;
+
+    // Nothing of a larger export is left behind in a smaller one.
+    let mut out = MeshGL::default();
+    let mut scratch = MeshGLScratch::default();
+    for (mesh, expected_volume) in [(&large, 1.875), (&small, 0.875), (&large, 1.875)] {
+        get_mesh_gl_into(mesh, -1, &mut out, &mut scratch);
+        assert_eq!(out.num_prop, 4);
+        assert_eq!(out.tri_verts.len(), 3 * mesh.num_tri());
+        assert_eq!(out.face_id.len(), mesh.num_tri());
+        assert_eq!(out.merge_from_vert.len(), out.merge_to_vert.len());
+        assert_eq!(out.run_index.len(), out.run_original_id.len() + 1);
+        let num_vert = (out.vert_properties.len() / 4) as u32;
+        assert!(out.tri_verts.iter().all(|&v| v < num_vert));
+        assert!((volume(&out) - expected_volume).abs() < 1e-5);
+    }
+
+    // Once grown, the buffers are refilled in place.
+    let vert_properties = out.vert_properties.as_ptr();
+    let tri_verts = out.tri_verts.as_ptr();
+    get_mesh_gl_into(&small, -1, &mut out, &mut scratch);
+    assert_eq!(out.vert_properties.as_ptr(), vert_properties);
+    assert_eq!(out.tri_verts.as_ptr(), tri_verts);
+}
+
+#[test]
+fn test_mesh_gl_into_transforms_normals() {
+    // Not an original, so the normals of each run are rotated by its
+    // transform, and flipped for the subtracted part.
+    let a = cube_with_normals();
+    let b = rotate(&translate(&a, Point3::new(0.5, 0.4, 0.3)), 30.0, 40.0, 50.0);
+    let part = &a - &b;
+    let expected = get_mesh_gl(&part, 0);
+    assert_eq!(expected.num_prop, 6);
+
+    let mut out = MeshGL::default();
+    let mut scratch = MeshGLScratch::default();
+    get_mesh_gl_into(&part, 0, &mut out, &mut scratch);
+    assert_eq!(out.vert_properties, expected.vert_properties);
+    assert_eq!(out.tri_verts, expected.tri_verts);
+
+    let mut chunked = Vec::new();
+    for chunk in mesh_gl_chunks::<f32, u32>(&part, 0, 5) {
+        chunked.extend(chunk.vert_properties);
+    }
+    assert_eq!(chunked, expected.vert_properties);
+
+    // Every exported normal is a unit vector along its flat face, facing out.
+    let prop = |v: u32, i: usize| {
+        Vector3::from_column_slice(&expected.vert_properties[6 * v as usize + i..][..3])
+    };
+    for tri in expected.tri_verts.chunks(3) {
+        let face = (prop(tri[1], 0) - prop(tri[0], 0)).cross(&(prop(tri[2], 0) - prop(tri[0], 0)));
+        if face.norm() < 1e-4 {
+            continue;
+        }
+        for &v in tri {
+            let normal = prop(v, 3);
+            assert!((normal.norm() - 1.0).abs() < 1e-5);
+            assert!(normal.dot(&face.normalize()) > 0.999);
+        }
+    }
+}
+
+#[test]
+fn test_mesh_gl_keeps_zero_normals() {
+    // The plain cube has no properties, so its part of the union has zeros in
+    // the normal channel, which must not be normalized into NaN.
+    let plain = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), Point3::new(0.5, 0.5, 0.5));
+    let part = &cube_with_normals() + &plain;
+    let mesh = get_mesh_gl(&part, 0);
+    assert_eq!(mesh.num_prop, 6);
+
+    let mut num_zero = 0;
+    for vert in mesh.vert_properties.chunks(6) {
+        let normal = Vector3::new(vert[3], vert[4], vert[5]);
+        if normal == Vector3::zeros() {
+            num_zero += 1;
+        } else {
+            assert!((normal.norm() - 1.0).abs() < 1e-5, "{normal:?}");
+        }
+    }
+    assert!(num_zero > 0);
+}
+
+#[test]
+fn test_mesh_gl_chunks_concatenate() {
+    let a = from_mesh_gl(&cube_with_face_props());
+    let b = translate(&a, Point3::new(0.5, 0.5, 0.5));
+    let plain = cube(Vector3::new(1.0, 1.0, 1.0), false);
+    let plain = &plain - &translate(&plain, Point3::new(0.5, 0.5, 0.5));
+    for mesh in [&a - &b, plain] {
+        let expected = get_mesh_gl(&mesh, -1);
+        for max_tris in [1, 5, 1000] {
+            let mut all = MeshGL::default();
+            let mut num_chunk = 0;
+            for chunk in mesh_gl_chunks::<f32, u32>(&mesh, -1, max_tris) {
+                let num_prop = chunk.num_prop as usize;
+                assert!(chunk.tri_verts.len() <= 3 * max_tris);
+                if num_prop > 3 {
+                    assert!(chunk.vert_properties.len() <= 3 * max_tris * num_prop);
+                }
+                // Triangles only use verts of this chunk or earlier ones.
+                let num_vert = (all.vert_properties.len() + chunk.vert_properties.len()) / num_prop;
+                assert!(chunk.tri_verts.iter().all(|&v| (v as usize) < num_vert));
+                all.num_prop = chunk.num_prop;
+                all.tolerance = chunk.tolerance;
+                all.vert_properties.extend(chunk.vert_properties);
+                all.tri_verts.extend(chunk.tri_verts);
+                all.merge_from_vert.extend(chunk.merge_from_vert);
+                all.merge_to_vert.extend(chunk.merge_to_vert);
+                all.run_index.extend(chunk.run_index);
+                all.run_original_id.extend(chunk.run_original_id);
+                all.run_transform.extend(chunk.run_transform);
+                all.face_id.extend(chunk.face_id);
+                num_chunk += 1;
+            }
+            assert_eq!(num_chunk, expected.face_id.len().div_ceil(max_tris));
+            assert_eq!(all, expected);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+use meshbool::{ManifoldError, cube, get_mesh_gl, read_obj, translate, write_obj};
+use nalgebra::{Point3, Vector3};
+use std::io::ErrorKind;
+
+mod common;
+use common::volume;
+
+///A unit cube of quads with a normal per face, the bottom half red and the
+///top half blue.
+const CUBE: &str = "# unit cube
+v 0 0 0
+v 1 0 0
+v 1 1 0
+v 0 1 0
+v 0 0 1
+v 1 0 1
+v 1 1 1
+v 0 1 1
+vn 0 0 -1
+vn 0 0 1
+vn 0 -1 0
+vn 0 1 0
+vn -1 0 0
+vn 1 0 0
+g box
+usemtl red
+f 1//1 4//1 3//1 2//1
+f 1//3 2//3 6//3 5//3
+f 1//5 5//5 8//5 4//5
+usemtl blue
+f 5//2 6//2 7//2 8//2
+f 3//4 4//4 8//4 7//4
+f -7//6 -6//6 -2//6 -3//6
+";
+
+#[test]
+fn test_obj_read() {
+    let (result, layout) = read_obj(CUBE.as_bytes()).unwrap();
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), 8);
+    assert_eq!(result.num_tri(), 12);
+    assert_eq!(result.num_prop(), 3);
+    assert_eq!(layout.uv_idx, None);
+    assert_eq!(layout.normal_idx, Some(0));
+    let materials: Vec<_> = layout.groups.iter().map(|g| g.material.as_str()).collect();
+    assert_eq!(materials, ["red", "blue"]);
+    assert!((volume(&get_mesh_gl(&result, -1)) - 1.0).abs() < 1e-9);
+
+    let mesh = get_mesh_gl(&result, 0);
+    let ids: Vec<u32> = layout.groups.iter().map(|g| g.original_id).collect();
+    assert_eq!(mesh.run_original_id, ids);
+    assert_eq!(mesh.run_index, [0, 18, 36]);
+    // Each quad is one face.
+    assert_eq!(mesh.face_id.iter().filter(|&&f| f == mesh.face_id[0]).count(), 2);
+
+    let bad = CUBE.replace("f 1//1 4//1", "f 1//1 9//1");
+    assert_eq!(read_obj(bad.as_bytes()).unwrap_err().kind(), ErrorKind::InvalidData);
+}
+
+#[test]
+fn test_obj_materials_survive_boolean() {
+    let (part, layout) = read_obj(CUBE.as_bytes()).unwrap();
+    let tool = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), Point3::new(0.5, 0.5, 0.5));
+    let result = &part - &tool;
+
+    let mut bytes = Vec::new();
+    write_obj(&result, &layout, &mut bytes).unwrap();
+    let text = String::from_utf8(bytes).unwrap();
+    assert_eq!(text.matches("usemtl red").count(), 1);
+    assert_eq!(text.matches("usemtl blue").count(), 1);
+    assert_eq!(text.matches("usemtl (null)").count(), 1);
+
+    let (round_trip, round_layout) = read_obj(text.as_bytes()).unwrap();
+    assert_eq!(round_trip.status, ManifoldError::NoError);
+    assert_eq!(round_trip.num_tri(), result.num_tri());
+    assert!((volume(&get_mesh_gl(&round_trip, -1)) - 0.875).abs() < 1e-9);
+    let names: Vec<_> = round_layout
+        .groups
+        .iter()
+        .map(|g| (g.name.as_str(), g.material.as_str()))
+        .collect();
+    let tool_name = format!("original_{}", get_mesh_gl(&tool, -1).run_original_id[0]);
+    assert_eq!(names, [("box", "red"), ("box", "blue"), (tool_name.as_str(), "")]);
+    assert_eq!(round_layout.normal_idx, Some(0));
+}
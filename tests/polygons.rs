@@ -1,5 +1,8 @@
-use meshbool::{cube, cylinder, get_mesh_gl, translate};
-use nalgebra::{Point3, Vector3};
+use meshbool::{cube, cylinder, extrude, get_mesh_gl, translate};
+use nalgebra::{Point2, Point3, Vector2, Vector3};
+
+mod common;
+use common::volume;
 
 #[test]
 fn test_polygon_basic_functionality() {
@@ -75,3 +78,60 @@ fn test_polygon_properties() {
         assert!((vert_idx as usize) < expected_verts);
     }
 }
+
+#[test]
+fn test_polygon_extrude_large_outline() {
+    // Large enough to be triangulated by the monotone sweep rather than
+    // ear-clipping; monotone.rs checks that the sweep takes this outline
+    // without falling back.
+    let n = 12000;
+    let outline: Vec<Point2<f64>> = (0..n)
+        .map(|i| {
+            let angle = 2.0 * std::f64::consts::PI * i as f64 / n as f64;
+            let radius = if i % 3 == 0 { 0.8 } else { 1.0 };
+            Point2::new(radius * angle.cos(), radius * angle.sin())
+        })
+        .collect();
+    let area: f64 = (0..n)
+        .map(|i| 0.5 * outline[i].coords.perp(&outline[(i + 1) % n].coords))
+        .sum();
+
+    let mesh = get_mesh_gl(&extrude(&vec![outline], 2.0, 0, 0.0, Point2::new(1.0, 1.0)), 0);
+    assert_eq!(mesh.tri_verts.len() / 3, 2 * (n - 2) + 2 * n);
+    assert!((volume(&mesh) - 2.0 * area).abs() < 1e-4 * area);
+}
+
+#[test]
+fn test_polygon_extrude_islands_with_holes() {
+    // A sheet of separate rings, each an outer contour with a hole that has to
+    // be keyholed before ear-clipping.
+    let mut sheet = Vec::new();
+    for i in 0..10 {
+        for j in 0..10 {
+            let center = Point2::new(3.0 * i as f64, 3.0 * j as f64);
+            let ring = |n: usize, radius: f64, dir: f64| -> Vec<Point2<f64>> {
+                (0..n)
+                    .map(|k| {
+                        let angle = dir * 2.0 * std::f64::consts::PI * k as f64 / n as f64;
+                        center + radius * Vector2::new(angle.cos(), angle.sin())
+                    })
+                    .collect()
+            };
+            sheet.push(ring(24, 1.0, 1.0));
+            sheet.push(ring(12, 0.4, -1.0));
+        }
+    }
+    let area: f64 = sheet
+        .iter()
+        .map(|poly| {
+            (0..poly.len())
+                .map(|i| 0.5 * poly[i].coords.perp(&poly[(i + 1) % poly.len()].coords))
+                .sum::<f64>()
+        })
+        .sum();
+
+    let mesh = get_mesh_gl(&extrude(&sheet, 1.0, 0, 0.0, Point2::new(1.0, 1.0)), 0);
+    // Each ring's cap has as many triangles as verts, plus its sides.
+    assert_eq!(mesh.tri_verts.len() / 3, 100 * (2 * 36 + 2 * 36));
+    assert!((volume(&mesh) - area).abs() < 1e-4 * area);
+}
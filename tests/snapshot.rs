@@ -0,0 +1,63 @@
+use meshbool::{
+    cube, cylinder, get_mesh_gl, read_snapshot, reserve_ids, translate, write_snapshot,
+    ManifoldError,
+};
+use nalgebra::{Point3, Vector3};
+use std::io::ErrorKind;
+
+fn part() -> meshbool::Impl {
+    let stock = cylinder(2.0, 1.0, 1.0, 32, true);
+    &stock - &translate(&cube(Vector3::new(0.5, 0.5, 3.0), true), Point3::new(0.5, 0.2, 0.0))
+}
+
+#[test]
+fn test_snapshot_round_trip() {
+    let a = part();
+    let mut bytes = Vec::new();
+    write_snapshot(&a, &mut bytes).unwrap();
+    assert_eq!(bytes.len() % 8, 0);
+
+    let b = read_snapshot(&mut bytes.as_slice()).unwrap();
+    assert_eq!(b.status, ManifoldError::NoError);
+    let (mesh_a, mesh_b) = (get_mesh_gl(&a, 0), get_mesh_gl(&b, 0));
+    assert_eq!(mesh_a.tri_verts, mesh_b.tri_verts);
+    assert_eq!(mesh_a.vert_properties, mesh_b.vert_properties);
+    assert_eq!(mesh_a.run_original_id, mesh_b.run_original_id);
+    assert_eq!(mesh_a.run_transform, mesh_b.run_transform);
+    assert_eq!(mesh_a.face_id, mesh_b.face_id);
+
+    // The loaded collider and relations work as before.
+    let tool = translate(&cube(Vector3::new(0.3, 3.0, 0.3), true), Point3::new(-0.4, 0.0, 0.2));
+    let cut_a = get_mesh_gl(&(&a - &tool), 0);
+    let cut_b = get_mesh_gl(&(&b - &tool), 0);
+    assert_eq!(cut_a.tri_verts, cut_b.tri_verts);
+    assert_eq!(cut_a.vert_properties, cut_b.vert_properties);
+
+    // New mesh IDs do not collide with loaded ones.
+    let max_id = *mesh_b.run_original_id.iter().max().unwrap();
+    assert!(reserve_ids(1) > max_id);
+}
+
+#[test]
+fn test_snapshot_rejects_corrupt_data() {
+    let mut bytes = Vec::new();
+    write_snapshot(&part(), &mut bytes).unwrap();
+
+    let err = |bytes: &[u8]| read_snapshot(&mut &bytes[..]).unwrap_err().kind();
+    assert_eq!(err(&bytes[..bytes.len() - 8]), ErrorKind::UnexpectedEof);
+
+    let mut magic = bytes.clone();
+    magic[0] ^= 1;
+    assert_eq!(err(&magic), ErrorKind::InvalidData);
+
+    let mut version = bytes.clone();
+    version[8] += 1;
+    assert_eq!(err(&version), ErrorKind::InvalidData);
+
+    // Point the first halfedge at a vert past the end.
+    let mut index = bytes.clone();
+    let num_vert = u64::from_le_bytes(bytes[96..104].try_into().unwrap()) as usize;
+    let first_halfedge = 168 + 24 * num_vert + (24 * num_vert) % 8;
+    index[first_halfedge..first_halfedge + 4].copy_from_slice(&(num_vert as i32).to_le_bytes());
+    assert_eq!(err(&index), ErrorKind::InvalidData);
+}
@@ -0,0 +1,52 @@
+use meshbool::{ManifoldError, cube, get_mesh_gl, read_stl, translate, write_stl};
+use nalgebra::{Point3, Vector3};
+use std::io::ErrorKind;
+
+mod common;
+use common::volume;
+
+#[test]
+fn test_stl_binary_round_trip() {
+    let a = cube(Vector3::new(2.0, 2.0, 2.0), true);
+    let b = translate(&cube(Vector3::new(1.0, 1.0, 1.0), false), Point3::new(0.5, 0.5, 0.5));
+    let part = &a - &b;
+    let mut bytes = Vec::new();
+    write_stl(&part, &mut bytes).unwrap();
+    assert_eq!(bytes.len(), 84 + 50 * part.num_tri());
+
+    let result = read_stl(bytes.as_slice()).unwrap();
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), part.num_vert());
+    assert_eq!(result.num_tri(), part.num_tri());
+    assert!((volume(&get_mesh_gl(&result, 0)) - 7.875).abs() < 1e-5);
+
+    // A binary header may begin with "solid" too.
+    bytes[..6].copy_from_slice(b"solid ");
+    assert_eq!(read_stl(bytes.as_slice()).unwrap().num_tri(), part.num_tri());
+
+    bytes.truncate(bytes.len() - 10);
+    assert_eq!(read_stl(bytes.as_slice()).unwrap_err().kind(), ErrorKind::UnexpectedEof);
+}
+
+#[test]
+fn test_stl_ascii() {
+    let corners = [[0.0, 0.0, 0.0], [1.0, 0.0, 0.0], [0.0, 1.0, 0.0], [0.0, 0.0, 1.0]];
+    let mut text = String::from("solid tetrahedron\n");
+    for tri in [[0, 2, 1], [0, 1, 3], [1, 2, 3], [0, 3, 2]] {
+        text += "  facet normal 0 0 0\n    outer loop\n";
+        for v in tri {
+            let [x, y, z] = corners[v];
+            text += &format!("      vertex {x:e} {y} {z}\n");
+        }
+        text += "    endloop\n  endfacet\n";
+    }
+    text += "endsolid tetrahedron\n";
+
+    let result = read_stl(text.as_bytes()).unwrap();
+    assert_eq!(result.status, ManifoldError::NoError);
+    assert_eq!(result.num_vert(), 4);
+    assert!((volume(&get_mesh_gl(&result, 0)) - 1.0 / 6.0).abs() < 1e-6);
+
+    let bad = text.replacen("vertex 0e0 0 0", "vertex 0 zero 0", 1);
+    assert_eq!(read_stl(bad.as_bytes()).unwrap_err().kind(), ErrorKind::InvalidData);
+}
@@ -0,0 +1,151 @@
+use meshbool::{OpType, boolean, cube, rotate, translate, write_3mf};
+use nalgebra::{Point3, Vector3};
+use std::collections::HashMap;
+
+fn crc32(bytes: &[u8]) -> u32 {
+    let mut crc = !0u32;
+    for &b in bytes {
+        crc ^= b as u32;
+        for _ in 0..8 {
+            crc = if crc & 1 != 0 {
+                0xEDB88320 ^ (crc >> 1)
+            } else {
+                crc >> 1
+            };
+        }
+    }
+    !crc
+}
+
+///Reads a zip of stored entries through its central directory, checking each
+///entry's local header and CRC.
+fn unzip(bytes: &[u8]) -> HashMap<String, Vec<u8>> {
+    let u16_at = |i: usize| u16::from_le_bytes(bytes[i..i + 2].try_into().unwrap()) as usize;
+    let u32_at = |i: usize| u32::from_le_bytes(bytes[i..i + 4].try_into().unwrap()) as usize;
+    let end = bytes.len() - 22;
+    assert_eq!(u32_at(end), 0x06054b50);
+    let num_entry = u16_at(end + 10);
+    let mut at = u32_at(end + 16);
+    assert_eq!(at + u32_at(end + 12), end);
+
+    let mut entries = HashMap::new();
+    for _ in 0..num_entry {
+        assert_eq!(u32_at(at), 0x02014b50);
+        assert_eq!(u16_at(at + 10), 0, "entries are stored");
+        let (crc, size) = (u32_at(at + 16) as u32, u32_at(at + 24));
+        let name_len = u16_at(at + 28);
+        let name = String::from_utf8(bytes[at + 46..at + 46 + name_len].to_vec()).unwrap();
+        let local = u32_at(at + 42);
+        assert_eq!(u32_at(local), 0x04034b50);
+        assert_eq!(&bytes[local + 30..local + 30 + name_len], name.as_bytes());
+        let data = &bytes[local + 30 + name_len..][..size];
+        assert_eq!(crc32(data), crc, "{name}");
+        entries.insert(name, data.to_vec());
+        at += 46 + name_len;
+    }
+    entries
+}
+
+fn count(text: &str, pattern: &str) -> usize {
+    text.matches(pattern).count()
+}
+
+///Checks that the triangles of a mesh object pair up along every edge, as the
+///3MF core spec requires.
+fn assert_closed(object: &str) {
+    let attr = |tri: &str, name: &str| -> u32 {
+        let value = &tri[tri.find(&format!("{name}=\"")).unwrap() + name.len() + 2..];
+        value[..value.find('"').unwrap()].parse().unwrap()
+    };
+    let mut edges: HashMap<(u32, u32), i32> = HashMap::new();
+    for tri in object.split("<triangle ").skip(1) {
+        let verts = [attr(tri, "v1"), attr(tri, "v2"), attr(tri, "v3")];
+        for i in 0..3 {
+            *edges.entry((verts[i], verts[(i + 1) % 3])).or_default() += 1;
+        }
+    }
+    for (&(v0, v1), &count) in &edges {
+        assert_eq!(count, 1);
+        assert_eq!(edges.get(&(v1, v0)), Some(&1), "open edge in mesh");
+    }
+}
+
+///The model XML, after checking that every mesh is closed and that its
+///components reference meshes with num_tri triangles in all.
+fn write_model(part: &meshbool::Impl) -> String {
+    let mut bytes = Vec::new();
+    write_3mf(part, &mut bytes).unwrap();
+    let entries = unzip(&bytes);
+    assert!(entries.contains_key("[Content_Types].xml"));
+    assert!(entries.contains_key("_rels/.rels"));
+    let model = String::from_utf8(entries["3D/3dmodel.model"].clone()).unwrap();
+
+    let mut object_tris = HashMap::new();
+    for object in model.split("<object id=\"").skip(1) {
+        let id: usize = object[..object.find('"').unwrap()].parse().unwrap();
+        object_tris.insert(id, count(object, "<triangle "));
+        assert_closed(object);
+    }
+    let instanced_tris: usize = model
+        .split("<component objectid=\"")
+        .skip(1)
+        .map(|c| object_tris[&c[..c.find('"').unwrap()].parse::<usize>().unwrap()])
+        .sum();
+    assert_eq!(instanced_tris, part.num_tri());
+    model
+}
+
+#[test]
+fn test_3mf_instances() {
+    let part = cube(Vector3::new(1.0, 1.0, 1.0), true);
+    let mut plate = part.clone();
+    for i in 1..4 {
+        let copy = rotate(&part, 0.0, 0.0, 30.0 * i as f64);
+        plate = boolean(
+            &plate,
+            &translate(&copy, Point3::new(3.0 * i as f64, 0.0, 0.0)),
+            OpType::Add,
+        );
+    }
+    assert_eq!(plate.num_tri(), 4 * 12);
+
+    let model = write_model(&plate);
+    assert_eq!(count(&model, "<mesh>"), 1);
+    assert_eq!(count(&model, "<vertex "), 8);
+    assert_eq!(count(&model, "<component "), 4);
+    assert_eq!(count(&model, "transform=\""), 3);
+    assert_eq!(count(&model, "<item "), 1);
+
+    // Cutting one copy leaves the others instanced. The cut copy and the faces
+    // of the notch are open by themselves, so they form one more mesh.
+    let notch = translate(
+        &cube(Vector3::new(1.0, 1.0, 1.0), true),
+        Point3::new(6.5, 0.5, 0.5),
+    );
+    let cut = boolean(&plate, &notch, OpType::Subtract);
+    let model = write_model(&cut);
+    assert_eq!(count(&model, "<mesh>"), 2);
+    assert_eq!(count(&model, "<component "), 4);
+    assert_eq!(count(&model, "transform=\""), 2);
+}
+
+#[test]
+fn test_3mf_mirrored_and_empty() {
+    let part = cube(Vector3::new(1.0, 2.0, 3.0), false);
+    let mirrored = meshbool::scale(&part, Vector3::new(-1.0, 1.0, 1.0));
+    let plate = boolean(
+        &part,
+        &translate(&mirrored, Point3::new(-2.0, 0.0, 0.0)),
+        OpType::Add,
+    );
+    // A mirror can't be a component of the same mesh without turning it inside
+    // out, so neither has a copy and both go in the one remaining mesh.
+    let model = write_model(&plate);
+    assert_eq!(count(&model, "<mesh>"), 1);
+    assert_eq!(count(&model, "<component "), 1);
+
+    let empty = boolean(&part, &part, OpType::Subtract);
+    let model = write_model(&empty);
+    assert_eq!(count(&model, "<object "), 0);
+    assert!(model.contains("<build>\n</build>"));
+}